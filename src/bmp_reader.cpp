@@ -4,6 +4,11 @@ namespace {
 const uint8_t BYTE = 8;
 const uint8_t FILE_HEADER_SIZE = 14;
 const uint8_t DIB_HEADER_SIZE = 40;
+const uint8_t V5_HEADER_SIZE = 124;
+
+const uint32_t BI_RGB = 0;
+const uint32_t BI_BITFIELDS = 3;
+const uint32_t BI_ALPHABITFIELDS = 6;
 
 enum FIELDS_OFFSET {
     application_specific = 6,
@@ -17,7 +22,28 @@ enum FIELDS_OFFSET {
     horizontal_resolution = 24,
     vertical_resolution = 28,
     color_pallete_size = 32,
-    important_color = 36
+    important_color = 36,
+    red_mask = 40,
+    green_mask = 44,
+    blue_mask = 48,
+    alpha_mask = 52
+};
+
+// channel of a 32-bit pixel described by its bit mask, the value is scaled to 0..255
+struct ChannelMask {
+    uint32_t mask;
+    int shift;
+    double factor;
+
+    explicit ChannelMask(uint32_t mask)
+        : mask(mask),
+          shift(mask == 0 ? 0 : std::countr_zero(mask)),
+          factor(mask == 0 ? 0. : 255. / static_cast<double>(mask >> shift)) {  // NOLINT
+    }
+
+    double Extract(uint32_t word) const {
+        return static_cast<double>((word & mask) >> shift) * factor;
+    }
 };
 }  // namespace
 
@@ -38,7 +64,138 @@ void bmp_reader::ByteWrite(uint8_t* array, const T& data, size_t start, size_t l
     }
 }
 
-Image* bmp_reader::ReadFile(const std::string& file_path, Image* img) {
+namespace {
+bmp_reader::Header ParseHeader(std::istream& f, const std::string& file_path) {
+    uint8_t file_header[FILE_HEADER_SIZE];
+    f.read(reinterpret_cast<char*>(file_header), FILE_HEADER_SIZE);
+
+    if (!f || (file_header[0] != 'B') || (file_header[1] != 'M')) {
+        throw UnsupportedFileFormat{file_path};
+    }
+
+    bmp_reader::Header header;
+    header.bitmap_offset = bmp_reader::ByteRead(file_header, FIELDS_OFFSET::bitmap_offset, 4);
+
+    // BITMAPINFOHEADER and its V2-V5 extensions share the first 40 bytes
+    uint8_t information_header[V5_HEADER_SIZE + 4] = {};
+    f.read(reinterpret_cast<char*>(information_header), 4);
+    const uint32_t dib_header_size = bmp_reader::ByteRead(information_header, 0, 4);
+
+    if (dib_header_size < DIB_HEADER_SIZE || dib_header_size > V5_HEADER_SIZE) {
+        throw UnsupportedFileFormat{std::to_string(dib_header_size) + " bytes DIB header"};
+    }
+
+    f.read(reinterpret_cast<char*>(information_header) + 4, dib_header_size - 4);
+
+    header.width = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::width, 4);
+    const auto signed_height = static_cast<int32_t>(bmp_reader::ByteRead(information_header, FIELDS_OFFSET::height, 4));
+    header.top_down = signed_height < 0;
+    header.height = std::abs(static_cast<int64_t>(signed_height));
+    header.bits_per_pixel = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::color_depth, 2);
+    header.compression = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::compression, 4);
+    header.horizontal_resolution = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::horizontal_resolution, 4);
+    header.vertical_resolution = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::vertical_resolution, 4);
+
+    if (header.compression == BI_BITFIELDS || header.compression == BI_ALPHABITFIELDS) {
+        // masks follow a 40 bytes header and are a part of the longer ones
+        if (dib_header_size == DIB_HEADER_SIZE) {
+            f.read(reinterpret_cast<char*>(information_header) + DIB_HEADER_SIZE,
+                   header.compression == BI_BITFIELDS ? 12 : 16);  // NOLINT
+        }
+
+        header.red_mask = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::red_mask, 4);
+        header.green_mask = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::green_mask, 4);
+        header.blue_mask = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::blue_mask, 4);
+        header.alpha_mask = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::alpha_mask, 4);
+    } else if (header.compression == BI_RGB) {
+        header.red_mask = 0x00FF0000;    // NOLINT
+        header.green_mask = 0x0000FF00;  // NOLINT
+        header.blue_mask = 0x000000FF;   // NOLINT
+        header.alpha_mask = 0;
+    } else {
+        throw UnsupportedFileFormat{"Compressed bitmap"};
+    }
+
+    if (header.bits_per_pixel <= BYTE) {
+        uint32_t colors = bmp_reader::ByteRead(information_header, FIELDS_OFFSET::color_pallete_size, 4);
+        colors = colors == 0 ? 1u << header.bits_per_pixel : std::min(colors, 1u << BYTE);
+
+        std::vector<uint8_t> palette(4 * colors);
+        f.read(reinterpret_cast<char*>(palette.data()), static_cast<std::streamsize>(palette.size()));
+
+        for (uint32_t i = 0; i != colors; ++i) {
+            header.palette.push_back(bmp_reader::ByteRead(palette.data(), 4 * i, 4));
+        }
+    }
+
+    if (!f) {
+        throw UnsupportedFileFormat{"Truncated header"};
+    }
+
+    const uint64_t row_size = (header.bits_per_pixel * header.width + 31) / 32 * 4;  // NOLINT
+    header.bitmap_size = row_size * header.height;
+
+    return header;
+}
+
+bool IsGrayscalePalette(const std::vector<uint32_t>& palette) {
+    return !palette.empty() && std::all_of(palette.begin(), palette.end(), [](uint32_t color) {
+        return (color & 0xFF) == ((color >> BYTE) & 0xFF) && (color & 0xFF) == ((color >> (2 * BYTE)) & 0xFF);  // NOLINT
+    });
+}
+
+bool IsMonochromePalette(const std::vector<uint32_t>& palette) {
+    return !palette.empty() && std::all_of(palette.begin(), palette.end(), [](uint32_t color) {
+        return (color & 0x00FFFFFF) == 0 || (color & 0x00FFFFFF) == 0x00FFFFFF;  // NOLINT
+    });
+}
+
+// decodes columns pixels of the row into 8-bit scale RGB samples
+void DecodeRow(const uint32_t* row, int64_t columns, int64_t bit_offset, const bmp_reader::Header& header,
+               double* rgb) {
+    if (header.bits_per_pixel <= BYTE) {
+        // pixels are indices into the palette, packed from the high bits of every byte
+        const auto* bytes = reinterpret_cast<const uint8_t*>(row);
+        const auto bits_per_pixel = static_cast<int64_t>(header.bits_per_pixel);
+        const uint32_t index_mask = (1u << bits_per_pixel) - 1;
+
+        for (int64_t x = 0; x != columns; ++x) {
+            const int64_t bit = bit_offset + x * bits_per_pixel;
+            const uint32_t index = (bytes[bit / BYTE] >> (BYTE - bits_per_pixel - bit % BYTE)) & index_mask;
+            const uint32_t color = index < header.palette.size() ? header.palette[index] : 0;
+
+            rgb[3 * x] = (color >> (2 * BYTE)) & 0xFF;  // NOLINT
+            rgb[3 * x + 1] = (color >> BYTE) & 0xFF;    // NOLINT
+            rgb[3 * x + 2] = color & 0xFF;              // NOLINT
+        }
+    } else if (header.bits_per_pixel == 4 * BYTE) {
+        // 32-bit pixels are read as aligned words, so channels are extracted without byte shuffling
+        const ChannelMask red(header.red_mask);
+        const ChannelMask green(header.green_mask);
+        const ChannelMask blue(header.blue_mask);
+
+        for (int64_t x = 0; x != columns; ++x) {
+            const uint32_t word = std::endian::native == std::endian::little
+                                      ? row[x]
+                                      : bmp_reader::ByteRead(reinterpret_cast<uint8_t*>(const_cast<uint32_t*>(row)),
+                                                             4 * x, 4);
+            rgb[3 * x] = red.Extract(word);
+            rgb[3 * x + 1] = green.Extract(word);
+            rgb[3 * x + 2] = blue.Extract(word);
+        }
+    } else {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(row);
+
+        for (int64_t x = 0; x != columns; ++x) {
+            rgb[3 * x] = bytes[3 * x + 2];
+            rgb[3 * x + 1] = bytes[3 * x + 1];
+            rgb[3 * x + 2] = bytes[3 * x];
+        }
+    }
+}
+}  // namespace
+
+bmp_reader::Header bmp_reader::ReadHeader(const std::string& file_path) {
     std::ifstream f;
     f.open(file_path, std::ios::in | std::ios::binary);
 
@@ -46,64 +203,102 @@ Image* bmp_reader::ReadFile(const std::string& file_path, Image* img) {
         throw FileNotFoundError{};
     }
 
-    uint8_t file_header[FILE_HEADER_SIZE];
-    f.read(reinterpret_cast<char*>(file_header), FILE_HEADER_SIZE);
-    size_t bitmap_offset = ByteRead(file_header, FIELDS_OFFSET::bitmap_offset, 4);
+    return ParseHeader(f, file_path);
+}
 
-    if ((file_header[0] != 'B') || (file_header[1] != 'M')) {
-        throw UnsupportedFileFormat{file_path};
-    }
-    if (bitmap_offset != FILE_HEADER_SIZE + DIB_HEADER_SIZE) {
-        throw UnsupportedFileFormat{"Not 54 bytes header"};
+namespace {
+Image* Decode(std::istream& f, Image* img, const ReadOptions& options, const std::string& name) {
+    const bmp_reader::Header header = ParseHeader(f, name);
+    const auto [width, height] = std::make_tuple(header.width, header.height);
+    const size_t bitmap_offset = header.bitmap_offset;
+
+    const bool indexed = header.bits_per_pixel == 1 || header.bits_per_pixel == 4 || header.bits_per_pixel == BYTE;
+    if (((header.bits_per_pixel != 3 * BYTE && !indexed) || header.compression != BI_RGB) &&
+        header.bits_per_pixel != 4 * BYTE) {
+        throw UnsupportedFileFormat{std::to_string(header.bits_per_pixel) + " bits color"};
     }
 
-    uint8_t information_header[DIB_HEADER_SIZE];
-    f.read(reinterpret_cast<char*>(information_header), DIB_HEADER_SIZE);
+    ImageBuilder builder(height, width, header.horizontal_resolution, header.vertical_resolution, options);
+    const Region& source = builder.Source();
 
-    int64_t width = ByteRead(information_header, FIELDS_OFFSET::width, 4);
-    int64_t height = ByteRead(information_header, FIELDS_OFFSET::height, 4);
-    size_t bits_per_pixel = ByteRead(information_header, FIELDS_OFFSET::color_depth, 2);
-    uint32_t horizontal_resolution = ByteRead(information_header, FIELDS_OFFSET::horizontal_resolution, 4);
-    uint32_t vertical_resolution = ByteRead(information_header, FIELDS_OFFSET::vertical_resolution, 4);
+    const auto bits_per_pixel = static_cast<int64_t>(header.bits_per_pixel);
+    const int64_t row_size = static_cast<int64_t>(header.bitmap_size) / std::max(1l, height);
+    const int64_t bit_offset = source.left * bits_per_pixel % BYTE;
+    const int64_t bytes_to_read = (bit_offset + source.width * bits_per_pixel + BYTE - 1) / BYTE;
+    std::vector<uint32_t> row((bytes_to_read + 3) / 4);
+    std::vector<double> rgb(3 * source.width);
 
-    if (bits_per_pixel != 3 * BYTE) {
-        throw UnsupportedFileFormat{std::to_string(bits_per_pixel) + " bits color"};
-    }
+    // rows are visited in the file order, so the file is only seeked forward
+    for (int64_t file_row = 0; file_row != height; ++file_row) {
+        const int64_t y = header.top_down ? file_row : height - 1 - file_row;
 
-    img = new Image(height, width, horizontal_resolution, vertical_resolution);
+        if (!builder.IsRowNeeded(y)) {
+            continue;
+        }
 
-    const uint16_t padding = (4 - (3 * width % 4)) % 4;
+        f.seekg(static_cast<std::streamoff>(bitmap_offset + file_row * row_size + source.left * bits_per_pixel / BYTE));
+        f.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(bytes_to_read));
 
-    for (int64_t i = 0; i != height; ++i) {
-        for (int64_t j = 0; j != width; ++j) {
-            uint8_t rgb[3];
-            f.read(reinterpret_cast<char*>(rgb), 3);
-
-            img->Get(height - i - 1, j) = Pixel(rgb[2], rgb[1], rgb[0]);
+        if (!f) {
+            throw UnsupportedFileFormat{"Truncated bitmap"};
         }
 
-        f.ignore(padding);
+        DecodeRow(row.data(), source.width, bit_offset, header, rgb.data());
+        builder.AddRow(y, rgb.data(), UINT8_MAX);
     }
 
-    f.close();
+    ColorMode color_mode = ColorMode::rgb;
+    if (IsMonochromePalette(header.palette)) {
+        color_mode = ColorMode::monochrome;
+    } else if (IsGrayscalePalette(header.palette)) {
+        color_mode = ColorMode::grayscale;
+    }
+
+    img = builder.Release(color_mode);
+
     return img;
 }
 
-void bmp_reader::SaveFile(const std::string& output_path, Image* img) {
-    std::fstream f;
-    f.open(output_path, std::ios::out | std::ios::binary);
+// sizes of the saved file
+struct Layout {
+    ColorDepth depth;
+    uint16_t bits_per_pixel;
+    uint32_t palette_size;
+    uint64_t row_size;
+    uint64_t bitmap_offset;
+    uint64_t bitmap_size;
+    uint64_t file_size;
+};
 
-    if (!f.is_open()) {
-        throw FileCreationError{};
+Layout MakeLayout(Image& img, const WriteOptions& options) {
+    auto [height, width] = img.Shape();
+
+    Layout layout{};
+    layout.depth = options.depth == ColorDepth::automatic ? DetectColorDepth(img) : options.depth;
+
+    const std::map<ColorDepth, uint16_t> depth_bits{
+        {ColorDepth::rgb, 3 * BYTE}, {ColorDepth::grayscale, BYTE}, {ColorDepth::monochrome, 1}};
+    layout.bits_per_pixel = depth_bits.at(layout.depth);
+    layout.palette_size = layout.depth == ColorDepth::rgb ? 0 : 1u << layout.bits_per_pixel;
+    layout.row_size = (layout.bits_per_pixel * width + 31) / 32 * 4;  // NOLINT
+    layout.bitmap_offset = FILE_HEADER_SIZE + DIB_HEADER_SIZE + 4 * layout.palette_size;
+    layout.bitmap_size = layout.row_size * height;
+    layout.file_size = layout.bitmap_offset + layout.bitmap_size;
+
+    // sizes are 32-bit fields of the headers
+    if (layout.file_size > UINT32_MAX || width > INT32_MAX || height > INT32_MAX) {
+        throw ImageTooLargeError{"BMP"};
     }
 
+    return layout;
+}
+
+void WriteBitmap(std::ostream& f, Image* img, const Layout& layout) {
+    using bmp_reader::ByteWrite;
+
     auto [height, width] = img->Shape();
     auto [horizontal_resolution, vertical_resolution] = img->Resolution();
-
-    const uint16_t padding = (4 - (3 * width % 4)) % 4;
-    const uint32_t bitmap_offset = FILE_HEADER_SIZE + DIB_HEADER_SIZE;
-    const uint32_t bitmap_size = 3 * height * width + height * padding;
-    const uint32_t file_size = FILE_HEADER_SIZE + DIB_HEADER_SIZE + bitmap_size;
+    const auto [depth, bits_per_pixel, palette_size, row_size, bitmap_offset, bitmap_size, file_size] = layout;
 
     uint8_t file_header[FILE_HEADER_SIZE];
     file_header[0] = 'B';
@@ -119,29 +314,82 @@ void bmp_reader::SaveFile(const std::string& output_path, Image* img) {
     ByteWrite(dib_header, DIB_HEADER_SIZE, 0, 4);
     ByteWrite(dib_header, width, FIELDS_OFFSET::width, 4);
     ByteWrite(dib_header, height, FIELDS_OFFSET::height, 4);
-    ByteWrite(dib_header, 1, FIELDS_OFFSET::color_planes, 2);        // Number of color planes
-    ByteWrite(dib_header, 3 * BYTE, FIELDS_OFFSET::color_depth, 2);  // Color depth, 24 bits
-    ByteWrite(dib_header, 0, FIELDS_OFFSET::compression, 4);         // No compession used
+    ByteWrite(dib_header, 1, FIELDS_OFFSET::color_planes, 2);              // Number of color planes
+    ByteWrite(dib_header, bits_per_pixel, FIELDS_OFFSET::color_depth, 2);  // Color depth, 24, 8 or 1 bits
+    ByteWrite(dib_header, 0, FIELDS_OFFSET::compression, 4);               // No compession used
     ByteWrite(dib_header, bitmap_size, FIELDS_OFFSET::bitmap_size, 4);
     ByteWrite(dib_header, horizontal_resolution, FIELDS_OFFSET::horizontal_resolution, 4);
     ByteWrite(dib_header, vertical_resolution, FIELDS_OFFSET::vertical_resolution, 4);
-    ByteWrite(dib_header, 0, FIELDS_OFFSET::color_pallete_size, 4);  // Number of colors in the pallete
-    ByteWrite(dib_header, 0, FIELDS_OFFSET::important_color, 4);     // Number of important colors
+    ByteWrite(dib_header, palette_size, FIELDS_OFFSET::color_pallete_size, 4);  // Number of colors in the pallete
+    ByteWrite(dib_header, 0, FIELDS_OFFSET::important_color, 4);                // Number of important colors
 
     f.write(reinterpret_cast<char*>(file_header), FILE_HEADER_SIZE);
     f.write(reinterpret_cast<char*>(dib_header), DIB_HEADER_SIZE);
 
-    uint8_t bmp_padding[3] = {0, 0, 0};
+    // gray palette: color with index i is (i, i, i), monochrome palette is black and white
+    for (uint32_t i = 0; i != palette_size; ++i) {
+        const auto level = static_cast<uint8_t>(i * UINT8_MAX / (palette_size - 1));
+        uint8_t color[] = {level, level, level, 0};
+        f.write(reinterpret_cast<char*>(color), 4);
+    }
+
+    std::vector<uint8_t> row(row_size, 0);
     for (int64_t i = 0; i != height; ++i) {
-        for (int64_t j = 0; j != width; ++j) {
-            auto [r, g, b] = img->Get(static_cast<int64_t>(height - i - 1), j).ToRGB();
-            uint8_t color[] = {b, g, r};
+        const std::vector<Pixel>& pixels = img->GetPixels()[height - i - 1];
+
+        if (depth == ColorDepth::monochrome) {
+            std::fill(row.begin(), row.end(), 0);
+        }
 
-            f.write(reinterpret_cast<char*>(color), 3);
+        for (int64_t j = 0; j != width; ++j) {
+            if (depth == ColorDepth::monochrome) {
+                // pixels are packed from the high bit of every byte
+                row[j / BYTE] |= static_cast<uint8_t>((GrayLevel(pixels[j]) > 0.5) << (BYTE - 1 - j % BYTE));  // NOLINT
+            } else if (depth == ColorDepth::grayscale) {
+                row[j] = static_cast<uint8_t>(GrayLevel(pixels[j]) * pixels[j].max_color);
+            } else {
+                auto [r, g, b] = pixels[j].ToRGB();
+                row[3 * j] = b;
+                row[3 * j + 1] = g;
+                row[3 * j + 2] = r;
+            }
         }
 
-        f.write(reinterpret_cast<char*>(bmp_padding), padding);
+        f.write(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row_size));
     }
+}
+}  // namespace
+
+Image* bmp_reader::ReadFile(const std::string& file_path, Image* img, const ReadOptions& options) {
+    std::ifstream f;
+    f.open(file_path, std::ios::in | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileNotFoundError{};
+    }
+
+    return Decode(f, img, options, file_path);
+}
 
+Image* bmp_reader::ReadStream(std::istream& f, Image* img, const ReadOptions& options) {
+    return Decode(f, img, options, "Input stream");
+}
+
+void bmp_reader::SaveFile(const std::string& output_path, Image* img, const WriteOptions& options) {
+    // the size is checked before the file is created
+    const Layout layout = MakeLayout(*img, options);
+
+    std::fstream f;
+    f.open(output_path, std::ios::out | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileCreationError{};
+    }
+
+    WriteBitmap(f, img, layout);
     f.close();
 }
+
+void bmp_reader::SaveStream(std::ostream& f, Image* img, const WriteOptions& options) {
+    WriteBitmap(f, img, MakeLayout(*img, options));
+}
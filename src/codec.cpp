@@ -0,0 +1,98 @@
+#include "../utils/codec.h"
+
+#include <algorithm>
+#include <limits>
+
+ImageBuilder::ImageBuilder(int64_t height, int64_t width, size_t horizontal_resolution, size_t vertical_resolution,
+                           const ReadOptions& options)
+    : height_(height), scale_(options.scale), scale_method_(options.scale_method), img_(nullptr) {
+    if (scale_ != 1 && scale_ != 2 && scale_ != 4 && scale_ != 8) {  // NOLINT
+        throw UnsupportedFileFormat{"1/" + std::to_string(scale_) + " scale"};
+    }
+
+    const int64_t scaled_height = (height + scale_ - 1) / scale_;
+    const int64_t scaled_width = (width + scale_ - 1) / scale_;
+
+    window_ = Region{0, 0, scaled_height, scaled_width};
+    if (options.window.has_value()) {
+        window_.top = std::min(scaled_height, std::max(0l, options.window->top));
+        window_.left = std::min(scaled_width, std::max(0l, options.window->left));
+        window_.height = std::min(scaled_height - window_.top, std::max(0l, options.window->height));
+        window_.width = std::min(scaled_width - window_.left, std::max(0l, options.window->width));
+    }
+
+    source_.top = window_.top * scale_;
+    source_.left = window_.left * scale_;
+    source_.height = std::min(height, (window_.top + window_.height) * scale_) - source_.top;
+    source_.width = std::min(width, (window_.left + window_.width) * scale_) - source_.left;
+
+    rows_added_.resize(window_.height);
+    img_ = new Image(window_.height, window_.width, horizontal_resolution / scale_, vertical_resolution / scale_);
+}
+
+int64_t ImageBuilder::BlockHeight(int64_t i) const {
+    if (scale_method_ == ScaleMethod::stride) {
+        return 1;
+    }
+
+    const int64_t first_row = (window_.top + i) * scale_;
+    return std::min(height_, first_row + scale_) - first_row;
+}
+
+double GrayLevel(const Pixel& pixel) {
+    if (pixel.r == pixel.g && pixel.g == pixel.b) {
+        return pixel.r;
+    }
+
+    return std::clamp(0.299 * pixel.r + 0.587 * pixel.g + 0.114 * pixel.b, 0., 1.);  // NOLINT
+}
+
+ColorDepth DetectColorDepth(Image& img) {
+    if (img.GetColorMode() == ColorMode::monochrome) {
+        return ColorDepth::monochrome;
+    }
+
+    bool monochrome = img.GetColorMode() != ColorMode::grayscale;
+    for (const auto& row : img.GetPixels()) {
+        for (const Pixel& pixel : row) {
+            auto [r, g, b] = pixel.ToRGB();
+
+            if (r != g || g != b) {
+                return ColorDepth::rgb;
+            }
+
+            monochrome = monochrome && (r == 0 || r == UINT8_MAX);
+        }
+    }
+
+    return monochrome ? ColorDepth::monochrome : ColorDepth::grayscale;
+}
+
+int64_t CheckRasterSize(int64_t height, int64_t width, int64_t pixel_size, const std::string& format) {
+    if (height <= 0 || width <= 0) {
+        throw UnsupportedFileFormat{"Wrong " + format + " header"};
+    }
+
+    if (width > std::numeric_limits<int64_t>::max() / pixel_size / height) {
+        throw ImageTooLargeError{format};
+    }
+
+    return height * width * pixel_size;
+}
+
+void CheckRemainingBytes(std::istream& f, int64_t size) {
+    const std::streamoff position = f.tellg();
+    f.seekg(0, std::ios::end);
+    const std::streamoff end = f.tellg();
+
+    if (position < 0 || end < 0) {
+        f.clear();
+        return;
+    }
+
+    f.seekg(position);
+
+    if (end - position < size) {
+        throw UnsupportedFileFormat{"Truncated raster"};
+    }
+}
@@ -2,9 +2,36 @@
 
 void console_interface::Help() {
     std::cout << "Wrong programm call arguments. You should follow the instruction:" << std::endl;
-    std::cout << "{executable file name} {input image path} {output image path} [-{filter alias 1} [filter parameter "
-                 "1] [filter parameter 2] ...] [-{filter alias 2} [filter parameter 1] [filter parameter 2] ...] ..."
+    std::cout << "{executable file name} {input image path} {output image path} [--scale {2|4|8}] "
+                 "[--fast-scale {2|4|8}] [--depth {auto|24|8|1}] [--sample-bits {8|16}] [--tile-size N] "
+                 "[--frame-size {width} {height}] [--matrix {601|709}] [--input-format {extension}] "
+                 "[--output-format {extension}] [-{filter alias 1} [filter parameter 1] "
+                 "[filter parameter 2] ...] [-{filter alias 2} [filter parameter 1] [filter parameter 2] ...] ..."
               << std::endl;
+    std::cout << "input and output image paths can be - for the standard input and output" << std::endl;
+    std::cout << "-roi {x} {y} {width} {height} before a filter applies it only inside the rectangle" << std::endl;
+    std::cout << "-mask {mask path} before a filter applies it only where the mask is not black" << std::endl;
+    std::cout << "{executable file name} {input image path} [decoder options] -o {output image path 1} [options] "
+                 "[filters] -o {output image path 2} ... - decode once and save several outputs"
+              << std::endl;
+    std::cout << "{executable file name} --probe {input image path} - print image metadata without decoding it"
+              << std::endl;
+    std::cout << "{executable file name} --graph {description path} - run a graph of filters with several inputs "
+                 "and outputs, the description path can be - for the standard input"
+              << std::endl;
+    std::cout << "{executable file name} --cache {directory} {input image path} {output image path} ... - copy the "
+                 "output of a job done before from the directory, or do the job and store its output there"
+              << std::endl;
+}
+
+void console_interface::PrintHeader(const bmp_reader::Header& header) {
+    std::cout << "width: " << header.width << std::endl;
+    std::cout << "height: " << header.height << std::endl;
+    std::cout << "row order: " << (header.top_down ? "top-down" : "bottom-up") << std::endl;
+    std::cout << "bits per pixel: " << header.bits_per_pixel << std::endl;
+    std::cout << "horizontal resolution: " << header.horizontal_resolution << std::endl;
+    std::cout << "vertical resolution: " << header.vertical_resolution << std::endl;
+    std::cout << "bitmap size: " << header.bitmap_size << std::endl;
 }
 
 size_t console_interface::ParseArguments(char** arguments, size_t start, size_t size, std::string& current_filter,
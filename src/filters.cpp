@@ -1,4 +1,8 @@
 #include "../utils/filters.h"
+#include "../utils/parallel.h"
+
+#include <algorithm>
+#include <span>
 
 std::tuple<double, double, double> AbstractMatrixFilter::ApplyMatrix(
     Image& img, int32_t y, int32_t x, const std::vector<std::vector<int16_t>>& matrix) const {
@@ -19,14 +23,13 @@ std::tuple<double, double, double> AbstractMatrixFilter::ApplyMatrix(
 
 const std::string CropFilter::ALIAS = "-crop";
 
-void CropFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+CropFilter::Parameters CropFilter::ParseParameters(std::queue<std::string> parameters) {
     if (parameters.size() != 2) {
         throw InvalidFilterParametersError{"crop"};
     }
 
-    auto [height, width] = img.Shape();
-    int64_t new_height = height;
-    int64_t new_width = width;
+    int64_t new_height = 0;
+    int64_t new_width = 0;
 
     try {
         new_width = std::stol(parameters.front());
@@ -41,45 +44,66 @@ void CropFilter::Apply(Image& img, std::queue<std::string> parameters) const {
         throw InvalidFilterParametersError{"crop"};
     }
 
+    return {new_width, new_height};
+}
+
+void CropFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+    Apply(img, ParseParameters(std::move(parameters)));
+}
+
+void CropFilter::Apply(Image& img, const Parameters& parameters) const {
+    auto [new_width, new_height] = parameters;
+    auto [height, width] = img.Shape();
+
     img.Reshape(std::min(height, new_height), std::min(width, new_width));
 }
 
 const std::string GrayscaleFilter::ALIAS = "-gs";
-const std::tuple<double, double, double> GrayscaleFilter::COEFS = {0.299, 0.587, 0.114};
 
-void GrayscaleFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+GrayscaleFilter::Parameters GrayscaleFilter::ParseParameters(std::queue<std::string> parameters) {
     if (!parameters.empty()) {
         throw InvalidFilterParametersError{"grayscale"};
     }
 
+    return {};
+}
+
+void GrayscaleFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+    Apply(img, ParseParameters(std::move(parameters)));
+}
+
+void GrayscaleFilter::Apply(Image& img, const Parameters& parameters) const {
     auto [height, width] = img.Shape();
 
     for (int64_t i = 0; i != height; ++i) {
         for (int64_t j = 0; j != width; ++j) {
-            Pixel multiplied = img.Get(i, j) * COEFS;
-            double new_color = multiplied.r + multiplied.g + multiplied.b;
-
-            img.Get(i, j) = Pixel(new_color, new_color, new_color);
+            Transform(img.Get(i, j));
         }
     }
+
+    img.SetColorMode(ColorMode::grayscale);
 }
 
 const std::string NegativeFilter::ALIAS = "-neg";
 
-void NegativeFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+NegativeFilter::Parameters NegativeFilter::ParseParameters(std::queue<std::string> parameters) {
     if (!parameters.empty()) {
         throw InvalidFilterParametersError{"negative"};
     }
 
+    return {};
+}
+
+void NegativeFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+    Apply(img, ParseParameters(std::move(parameters)));
+}
+
+void NegativeFilter::Apply(Image& img, const Parameters& parameters) const {
     auto [height, width] = img.Shape();
 
     for (int64_t i = 0; i != height; ++i) {
         for (int64_t j = 0; j != width; ++j) {
-            Pixel& current_pixel = img.Get(i, j);
-
-            current_pixel.r = 1 - current_pixel.r;
-            current_pixel.g = 1 - current_pixel.g;
-            current_pixel.b = 1 - current_pixel.b;
+            Transform(img.Get(i, j));
         }
     }
 }
@@ -87,11 +111,23 @@ void NegativeFilter::Apply(Image& img, std::queue<std::string> parameters) const
 const std::string SharpeningFilter::ALIAS = "-sharp";
 const std::vector<std::vector<int16_t>> SharpeningFilter::FILTER_MATRIX = {{0, -1, 0}, {-1, 5, -1}, {0, -1, 0}};
 
-void SharpeningFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+SharpeningFilter::Parameters SharpeningFilter::ParseParameters(std::queue<std::string> parameters) {
     if (!parameters.empty()) {
         throw InvalidFilterParametersError{"sharpening"};
     }
 
+    return {};
+}
+
+int64_t SharpeningFilter::Radius(const Parameters& parameters) {
+    return static_cast<int64_t>(FILTER_MATRIX.size()) / 2;
+}
+
+void SharpeningFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+    Apply(img, ParseParameters(std::move(parameters)));
+}
+
+void SharpeningFilter::Apply(Image& img, const Parameters& parameters) const {
     auto [height, width] = img.Shape();
     std::vector<std::vector<Pixel>> new_data(height, std::vector<Pixel>(width));
 
@@ -103,12 +139,16 @@ void SharpeningFilter::Apply(Image& img, std::queue<std::string> parameters) con
     }
 
     img.GetPixels() = std::move(new_data);
+
+    if (img.GetColorMode() == ColorMode::monochrome) {
+        img.SetColorMode(ColorMode::grayscale);
+    }
 }
 
 const std::string EdgeDetectionFilter::ALIAS = "-edge";
 const std::vector<std::vector<int16_t>> EdgeDetectionFilter::FILTER_MATRIX = {{0, -1, 0}, {-1, 4, -1}, {0, -1, 0}};
 
-void EdgeDetectionFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+EdgeDetectionFilter::Parameters EdgeDetectionFilter::ParseParameters(std::queue<std::string> parameters) {
     if (parameters.size() != 1) {
         throw InvalidFilterParametersError{"edge detection"};
     }
@@ -125,17 +165,42 @@ void EdgeDetectionFilter::Apply(Image& img, std::queue<std::string> parameters)
         throw InvalidFilterParametersError{"edge detection"};
     }
 
+    return {threshold};
+}
+
+int64_t EdgeDetectionFilter::Radius(const Parameters& parameters) {
+    return static_cast<int64_t>(FILTER_MATRIX.size()) / 2;
+}
+
+void EdgeDetectionFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+    Apply(img, ParseParameters(std::move(parameters)));
+}
+
+std::vector<std::vector<double>> EdgeDetectionFilter::Response(Image& img) const {
     auto [height, width] = img.Shape();
 
-    GrayscaleFilter().Apply(img, parameters);
+    GrayscaleFilter().Apply(img, GrayscaleFilter::Parameters{});
 
-    std::vector<std::vector<Pixel>> new_data(height, std::vector<Pixel>(width));
+    std::vector<std::vector<double>> response(height, std::vector<double>(width));
 
     for (int64_t i = 0; i != height; ++i) {
         for (int64_t j = 0; j != width; ++j) {
-            auto new_color = this->ApplyMatrix(img, static_cast<int32_t>(i), static_cast<int32_t>(j), FILTER_MATRIX);
+            response[i][j] =
+                std::get<0>(this->ApplyMatrix(img, static_cast<int32_t>(i), static_cast<int32_t>(j), FILTER_MATRIX));
+        }
+    }
+
+    return response;
+}
+
+void EdgeDetectionFilter::Threshold(Image& img, const std::vector<std::vector<double>>& response, double threshold) {
+    const auto height = static_cast<int64_t>(response.size());
+    const auto width = static_cast<int64_t>(response.empty() ? 0 : response.front().size());
+    std::vector<std::vector<Pixel>> new_data(height, std::vector<Pixel>(width));
 
-            if (std::get<0>(new_color) >= threshold) {
+    for (int64_t i = 0; i != height; ++i) {
+        for (int64_t j = 0; j != width; ++j) {
+            if (response[i][j] >= threshold) {
                 new_data[i][j] = Pixel(1., 1., 1.);
             } else {
                 new_data[i][j] = Pixel(0., 0., 0.);
@@ -144,6 +209,12 @@ void EdgeDetectionFilter::Apply(Image& img, std::queue<std::string> parameters)
     }
 
     img.GetPixels() = std::move(new_data);
+    img.Reshape(height, width);
+    img.SetColorMode(ColorMode::monochrome);
+}
+
+void EdgeDetectionFilter::Apply(Image& img, const Parameters& parameters) const {
+    Threshold(img, Response(img), parameters.threshold);
 }
 
 const std::string GaussianBlurFilter::ALIAS = "-blur";
@@ -165,6 +236,10 @@ std::vector<double> GaussianBlurFilter::CalculateGaussianCoefficients(double sig
     return coefficients;
 }
 
+int64_t GaussianBlurFilter::Radius(const Parameters& parameters) {
+    return static_cast<int64_t>(CalculateGaussianCoefficients(parameters.sigma).size() - 1) / 2;
+}
+
 void GaussianBlurFilter::ApplyOneWayBlur(Image& img, const std::vector<double> gaussian_coefficients,
                                          BlurDirection direction) const {
     auto [height, width] = img.Shape();
@@ -198,7 +273,7 @@ void GaussianBlurFilter::ApplyOneWayBlur(Image& img, const std::vector<double> g
     img.GetPixels() = std::move(new_data);
 }
 
-void GaussianBlurFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+GaussianBlurFilter::Parameters GaussianBlurFilter::ParseParameters(std::queue<std::string> parameters) {
     if (parameters.size() != 1) {
         throw InvalidFilterParametersError{"blur"};
     }
@@ -215,7 +290,444 @@ void GaussianBlurFilter::Apply(Image& img, std::queue<std::string> parameters) c
         throw InvalidFilterParametersError{"blur"};
     }
 
-    std::vector<double> gaussian_coefficients = CalculateGaussianCoefficients(sigma);
+    return {sigma};
+}
+
+void GaussianBlurFilter::Apply(Image& img, std::queue<std::string> parameters) const {
+    Apply(img, ParseParameters(std::move(parameters)));
+}
+
+void GaussianBlurFilter::Apply(Image& img, const Parameters& parameters) const {
+    std::vector<double> gaussian_coefficients = CalculateGaussianCoefficients(parameters.sigma);
     ApplyOneWayBlur(img, gaussian_coefficients, BlurDirection::horizontal);  // true - horizontal blur
     ApplyOneWayBlur(img, gaussian_coefficients, BlurDirection::vertical);    // false - vertical blur
+
+    if (img.GetColorMode() == ColorMode::monochrome) {
+        img.SetColorMode(ColorMode::grayscale);
+    }
+}
+
+void PointFilter::Apply(Image& img, const Parameters& parameters) const {
+    // a block of pixels stays in the cache while all operations are applied to it
+    const size_t block_size = 512;
+
+    for (std::vector<Pixel>& row : img.GetPixels()) {
+        for (size_t begin = 0; begin < row.size(); begin += block_size) {
+            const auto block = std::span(row).subspan(begin, std::min(block_size, row.size() - begin));
+
+            for (Operation operation : parameters.operations) {
+                if (operation == Operation::grayscale) {
+                    std::for_each(block.begin(), block.end(), GrayscaleFilter::Transform);
+                } else {
+                    std::for_each(block.begin(), block.end(), NegativeFilter::Transform);
+                }
+            }
+        }
+    }
+
+    const std::vector<Operation>& operations = parameters.operations;
+    if (std::find(operations.begin(), operations.end(), Operation::grayscale) != operations.end()) {
+        img.SetColorMode(ColorMode::grayscale);
+    }
+}
+
+namespace {
+// the region with the halo around it, the halo is cut at the image borders, where filters clamp coordinates
+// as on the whole image, so the pixels filters compute wrong near the other borders stay in the halo
+Region AddHalo(const Region& region, int64_t halo, int64_t height, int64_t width) {
+    const int64_t top = std::max(0l, region.top - halo);
+    const int64_t left = std::max(0l, region.left - halo);
+    const int64_t bottom = std::min(height, region.top + region.height + halo);
+    const int64_t right = std::min(width, region.left + region.width + halo);
+
+    return {top, left, bottom - top, right - left};
+}
+
+Image CutRegion(const Image& img, const Region& region) {
+    Image part(region.height, region.width, 0, 0);
+    part.SetColorMode(img.GetColorMode());
+
+    for (int64_t y = region.top; y != region.top + region.height; ++y) {
+        const std::vector<Pixel>& row = img.GetPixels()[y];
+        std::copy(row.begin() + region.left, row.begin() + region.left + region.width,
+                  part.GetPixels()[y - region.top].begin());
+    }
+
+    return part;
+}
+
+// copies the core of the part cut out at part_region to the same place of pixels
+void PasteCore(const Image& part, const Region& part_region, const Region& core,
+               std::vector<std::vector<Pixel>>& pixels) {
+    for (int64_t y = core.top; y != core.top + core.height; ++y) {
+        const std::vector<Pixel>& row = part.GetPixels()[y - part_region.top];
+        const int64_t left = core.left - part_region.left;
+        std::copy(row.begin() + left, row.begin() + left + core.width, pixels[y].begin() + core.left);
+    }
+}
+
+// black and white images are grayscale, and grayscale images are color
+ColorMode WiderColorMode(ColorMode first, ColorMode second) {
+    return std::min(first, second);
+}
+}  // namespace
+
+void TiledFilter::Apply(Image& img, const Parameters& parameters) const {
+    const int64_t min_tile_size = 128;
+
+    // tiles are large enough for the halo to be a small part of the work
+    auto [height, width] = img.Shape();
+    const int64_t halo = parameters.halo;
+    const int64_t tile_size = std::max(min_tile_size, 4 * halo);
+    const int64_t tiles_across = (width + tile_size - 1) / tile_size;
+    const int64_t tiles_count = tiles_across * ((height + tile_size - 1) / tile_size);
+
+    std::vector<std::vector<Pixel>> new_data(height, std::vector<Pixel>(width));
+    ColorMode color_mode = img.GetColorMode();
+
+    ParallelFor(tiles_count, [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t != end; ++t) {
+            const int64_t top = t / tiles_across * tile_size;
+            const int64_t left = t % tiles_across * tile_size;
+            const Region core{top, left, std::min(tile_size, height - top), std::min(tile_size, width - left)};
+            const Region tile_region = AddHalo(core, halo, height, width);
+
+            Image tile = CutRegion(img, tile_region);
+
+            for (const auto& stage : parameters.stages) {
+                stage(tile);
+            }
+
+            PasteCore(tile, tile_region, core, new_data);
+
+            // every tile goes through the same color mode changes
+            if (t == 0) {
+                color_mode = tile.GetColorMode();
+            }
+        }
+    });
+
+    img.GetPixels() = std::move(new_data);
+    img.SetColorMode(color_mode);
+}
+
+const std::string RegionFilter::ALIAS = "-roi";
+
+RegionFilter::Parameters RegionFilter::ParseParameters(std::queue<std::string> parameters) {
+    if (parameters.size() != 4) {
+        throw InvalidFilterParametersError{"region"};
+    }
+
+    std::vector<int64_t> values;
+
+    try {
+        while (!parameters.empty()) {
+            values.push_back(std::stol(parameters.front()));
+            parameters.pop();
+        }
+    } catch (const std::invalid_argument& e) {
+        throw InvalidFilterParametersError{"region"};
+    }
+
+    if (std::any_of(values.begin(), values.end(), [](int64_t value) { return value < 0; })) {
+        throw InvalidFilterParametersError{"region"};
+    }
+
+    return {Region{values[1], values[0], values[3], values[2]}, nullptr, 0, {}};
+}
+
+void RegionFilter::Apply(Image& img, const Parameters& parameters) const {
+    auto [height, width] = img.Shape();
+    const Region& region = parameters.region;
+
+    // the part of the region inside the image
+    const int64_t top = std::min(region.top, height);
+    const int64_t left = std::min(region.left, width);
+    const Region core{top, left, std::min(region.height, height - top), std::min(region.width, width - left)};
+
+    if (core.height == 0 || core.width == 0) {
+        return;
+    }
+
+    const Region part_region = AddHalo(core, parameters.halo, height, width);
+    Image part = CutRegion(img, part_region);
+    parameters.filter(part);
+    PasteCore(part, part_region, core, img.GetPixels());
+
+    // the filtered region and the rest of the image are stored in one color mode
+    const bool whole = core.height == height && core.width == width;
+    img.SetColorMode(whole ? part.GetColorMode() : WiderColorMode(img.GetColorMode(), part.GetColorMode()));
+}
+
+namespace {
+// brightness of the mask, gray pixels are taken as they are, so black and white masks select pixels exactly
+double MaskWeight(const Image& mask, int64_t y, int64_t x) {
+    Pixel pixel = mask.GetPixels()[y][x];
+    if (pixel.r != pixel.g || pixel.r != pixel.b) {
+        GrayscaleFilter::Transform(pixel);
+    }
+
+    return pixel.r;
+}
+
+// adjacent tiles of one row selected by the mask, filtered together
+struct MaskedRun {
+    Region core;
+    Region part_region;
+    Image part;
+};
+}  // namespace
+
+const std::string MaskedFilter::ALIAS = "-mask";
+
+MaskedFilter::Parameters MaskedFilter::ParseParameters(std::queue<std::string> parameters) {
+    if (parameters.size() != 1) {
+        throw InvalidFilterParametersError{"mask"};
+    }
+
+    return {parameters.front(), nullptr, nullptr, 0, {}};
+}
+
+void MaskedFilter::Apply(Image& img, const Parameters& parameters) const {
+    const int64_t min_tile_size = 64;
+
+    auto [height, width] = img.Shape();
+    const Image& mask = *parameters.mask;
+    auto [mask_height, mask_width] = mask.Shape();
+    const int64_t covered_height = std::min(height, mask_height);
+    const int64_t covered_width = std::min(width, mask_width);
+
+    // small tiles skip more of a sparse mask, but every run is filtered with its halo
+    const int64_t tile_size = std::max(min_tile_size, 2 * parameters.halo);
+    const int64_t tiles_across = (covered_width + tile_size - 1) / tile_size;
+    const int64_t tile_rows = (covered_height + tile_size - 1) / tile_size;
+
+    // the halos of the runs read the pixels around them, so the image is changed after all runs are filtered
+    std::vector<std::vector<MaskedRun>> runs(tile_rows);
+    std::vector<char> fully_selected(tile_rows, 1);
+
+    ParallelFor(tile_rows, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row != end; ++row) {
+            const int64_t top = row * tile_size;
+            const int64_t bottom = std::min(top + tile_size, covered_height);
+
+            // whether the mask selects any pixel of the tile and whether it selects all of them
+            auto classify = [&](int64_t tile) {
+                const int64_t left = tile * tile_size;
+                const int64_t right = std::min(left + tile_size, covered_width);
+                bool any = false;
+                bool all = true;
+
+                for (int64_t y = top; y != bottom; ++y) {
+                    for (int64_t x = left; x != right; ++x) {
+                        const double weight = MaskWeight(mask, y, x);
+                        any = any || weight > 0;
+                        all = all && weight == 1;
+                    }
+                }
+
+                return std::make_pair(any, all);
+            };
+
+            for (int64_t tile = 0; tile != tiles_across;) {
+                auto [any, all] = classify(tile);
+                fully_selected[row] = fully_selected[row] && all;
+
+                if (!any) {
+                    ++tile;
+                    continue;
+                }
+
+                int64_t last = tile + 1;
+                for (; last != tiles_across; ++last) {
+                    std::tie(any, all) = classify(last);
+                    fully_selected[row] = fully_selected[row] && all;
+
+                    if (!any) {
+                        break;
+                    }
+                }
+
+                const Region core{top, tile * tile_size, bottom - top,
+                                  std::min(last * tile_size, covered_width) - tile * tile_size};
+                const Region part_region = AddHalo(core, parameters.halo, height, width);
+                Image part = CutRegion(img, part_region);
+                parameters.filter(part);
+
+                runs[row].push_back({core, part_region, std::move(part)});
+                tile = std::min(last + 1, tiles_across);  // the tile after the run is already known to be skipped
+            }
+        }
+    });
+
+    const auto first = std::find_if(runs.begin(), runs.end(), [](const auto& row) { return !row.empty(); });
+    if (first == runs.end()) {
+        return;
+    }
+
+    const ColorMode filtered_color_mode = first->front().part.GetColorMode();
+    std::vector<char> mixed(tile_rows);
+    std::vector<std::vector<Pixel>>& pixels = img.GetPixels();
+
+    ParallelFor(tile_rows, [&](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row != end; ++row) {
+            for (const MaskedRun& run : runs[row]) {
+                const Region& core = run.core;
+
+                for (int64_t y = core.top; y != core.top + core.height; ++y) {
+                    const std::vector<Pixel>& filtered_row = run.part.GetPixels()[y - run.part_region.top];
+
+                    for (int64_t x = core.left; x != core.left + core.width; ++x) {
+                        const double weight = MaskWeight(mask, y, x);
+                        const Pixel& filtered = filtered_row[x - run.part_region.left];
+                        Pixel& pixel = pixels[y][x];
+
+                        if (weight == 1) {
+                            pixel = filtered;
+                        } else if (weight > 0) {
+                            pixel = Pixel(pixel.r * (1 - weight) + filtered.r * weight,
+                                          pixel.g * (1 - weight) + filtered.g * weight,
+                                          pixel.b * (1 - weight) + filtered.b * weight);
+                            mixed[row] = 1;
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    // mixed black and white pixels are gray
+    const bool whole = covered_height == height && covered_width == width &&
+                       std::all_of(fully_selected.begin(), fully_selected.end(), [](char all) { return all; });
+    ColorMode color_mode =
+        whole ? filtered_color_mode : WiderColorMode(img.GetColorMode(), filtered_color_mode);
+    if (color_mode == ColorMode::monochrome && std::find(mixed.begin(), mixed.end(), 1) != mixed.end()) {
+        color_mode = ColorMode::grayscale;
+    }
+
+    img.SetColorMode(color_mode);
+}
+
+namespace {
+// crops the first input to the part covered by all inputs
+void CropToCommonPart(Image& img, const std::vector<const Image*>& others) {
+    auto [height, width] = img.Shape();
+
+    for (const Image* other : others) {
+        auto [other_height, other_width] = other->Shape();
+        height = std::min(height, other_height);
+        width = std::min(width, other_width);
+    }
+
+    img.Reshape(height, width);
+}
+
+// mixed colors of grayscale images are gray, but not black and white
+ColorMode MixedColorMode(const Image& img, const Image& other) {
+    const bool rgb = img.GetColorMode() == ColorMode::rgb || other.GetColorMode() == ColorMode::rgb;
+    return rgb ? ColorMode::rgb : ColorMode::grayscale;
+}
+}  // namespace
+
+const std::string BlendFilter::ALIAS = "blend";
+
+BlendFilter::Parameters BlendFilter::ParseParameters(std::queue<std::string> parameters) {
+    if (parameters.size() != 1) {
+        throw InvalidFilterParametersError{"blend"};
+    }
+
+    double alpha = NAN;
+    try {
+        alpha = std::stod(parameters.front());
+        parameters.pop();
+    } catch (const std::invalid_argument& e) {
+        throw InvalidFilterParametersError{"blend"};
+    }
+
+    if (alpha < 0 || alpha > 1) {
+        throw InvalidFilterParametersError{"blend"};
+    }
+
+    return {alpha};
+}
+
+void BlendFilter::Apply(Image& img, const std::vector<const Image*>& others, const Parameters& parameters) const {
+    const ColorMode color_mode = MixedColorMode(img, *others[0]);
+    CropToCommonPart(img, others);
+    auto [height, width] = img.Shape();
+    const double alpha = parameters.alpha;
+
+    for (int64_t i = 0; i != height; ++i) {
+        for (int64_t j = 0; j != width; ++j) {
+            Pixel& pixel = img.Get(i, j);
+            const Pixel other = others[0]->Get(i, j);
+
+            pixel = Pixel(pixel.r * (1 - alpha) + other.r * alpha, pixel.g * (1 - alpha) + other.g * alpha,
+                          pixel.b * (1 - alpha) + other.b * alpha);
+        }
+    }
+
+    img.SetColorMode(color_mode);
+}
+
+const std::string MaskFilter::ALIAS = "mask";
+
+MaskFilter::Parameters MaskFilter::ParseParameters(std::queue<std::string> parameters) {
+    if (!parameters.empty()) {
+        throw InvalidFilterParametersError{"mask"};
+    }
+
+    return {};
+}
+
+void MaskFilter::Apply(Image& img, const std::vector<const Image*>& others, const Parameters& parameters) const {
+    // the mask does not change the color mode of the result
+    const ColorMode color_mode = MixedColorMode(img, *others[0]);
+    CropToCommonPart(img, others);
+    auto [height, width] = img.Shape();
+
+    for (int64_t i = 0; i != height; ++i) {
+        for (int64_t j = 0; j != width; ++j) {
+            Pixel& pixel = img.Get(i, j);
+            const Pixel other = others[0]->Get(i, j);
+
+            const double weight = MaskWeight(*others[1], i, j);
+
+            pixel = Pixel(pixel.r * weight + other.r * (1 - weight), pixel.g * weight + other.g * (1 - weight),
+                          pixel.b * weight + other.b * (1 - weight));
+        }
+    }
+
+    img.SetColorMode(color_mode);
+}
+
+const std::string DifferenceFilter::ALIAS = "difference";
+
+DifferenceFilter::Parameters DifferenceFilter::ParseParameters(std::queue<std::string> parameters) {
+    if (!parameters.empty()) {
+        throw InvalidFilterParametersError{"difference"};
+    }
+
+    return {};
+}
+
+void DifferenceFilter::Apply(Image& img, const std::vector<const Image*>& others,
+                             const Parameters& parameters) const {
+    // the difference of black and white images is black and white too
+    const bool monochrome =
+        img.GetColorMode() == ColorMode::monochrome && others[0]->GetColorMode() == ColorMode::monochrome;
+    const ColorMode color_mode = MixedColorMode(img, *others[0]);
+    CropToCommonPart(img, others);
+    auto [height, width] = img.Shape();
+
+    for (int64_t i = 0; i != height; ++i) {
+        for (int64_t j = 0; j != width; ++j) {
+            Pixel& pixel = img.Get(i, j);
+            const Pixel other = others[0]->Get(i, j);
+
+            pixel = Pixel(std::abs(pixel.r - other.r), std::abs(pixel.g - other.g), std::abs(pixel.b - other.b));
+        }
+    }
+
+    img.SetColorMode(monochrome ? ColorMode::monochrome : color_mode);
 }
@@ -0,0 +1,312 @@
+#include "../utils/graph.h"
+#include "../utils/image_io.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+
+namespace {
+const std::string SAVE_KEYWORD = "save";
+const std::string ASSIGNMENT = "=";
+const char COMMENT = '#';
+
+template <typename Filter>
+CombiningNode MakeCombiningNode(std::queue<std::string> parameters) {
+    return Node<Filter>{Filter::ParseParameters(std::move(parameters))};
+}
+
+struct Combiner {
+    size_t inputs;
+    CombiningNode (*parse)(std::queue<std::string>);
+};
+
+const std::map<std::string, Combiner> COMBINERS{
+    {BlendFilter::ALIAS, {BlendFilter::INPUTS, MakeCombiningNode<BlendFilter>}},
+    {MaskFilter::ALIAS, {MaskFilter::INPUTS, MakeCombiningNode<MaskFilter>}},
+    {DifferenceFilter::ALIAS, {DifferenceFilter::INPUTS, MakeCombiningNode<DifferenceFilter>}}};
+
+bool IsName(const std::string& token) {
+    return !token.empty() && std::all_of(token.begin(), token.end(), [](char c) { return std::isalnum(c) || c == '_'; });
+}
+
+bool IsAlias(const std::string& token) {
+    return token.size() > 1 && token[0] == '-';
+}
+
+// adds vertices to the graph, an operation already applied to the same inputs is reused
+class GraphBuilder {
+private:
+    Graph graph_;
+    std::map<std::string, size_t> names_;
+    std::map<std::string, size_t> vertices_;  // operation with its parameters and inputs -> vertex
+
+public:
+    size_t Add(Vertex vertex, const std::string& operation) {
+        std::string key = operation;
+        for (size_t input : vertex.inputs) {
+            key += ' ' + std::to_string(input);
+        }
+
+        const auto [found, inserted] = vertices_.try_emplace(key, graph_.vertices.size());
+        if (inserted) {
+            graph_.vertices.push_back(std::move(vertex));
+        }
+
+        return found->second;
+    }
+
+    // vertex of a name or of a file
+    size_t AddSource(const std::string& token, size_t line) {
+        if (names_.contains(token)) {
+            return names_.at(token);
+        }
+        if (IsName(token)) {
+            throw InvalidGraphError{line};  // paths have extensions, so this is an undefined name
+        }
+        if (!image_io::IsSupported(token)) {
+            throw UnsupportedFileFormat{token};
+        }
+        if (token != image_io::STANDARD_STREAM && !std::filesystem::exists(token)) {
+            throw FileNotFoundError{};
+        }
+
+        return Add({SourceNode{token}, {}}, "source " + token);
+    }
+
+    // "source [filters...]" from the given token, the source is a combining filter, a name or a file
+    size_t AddExpression(const std::vector<std::string>& tokens, size_t start, size_t line) {
+        size_t vertex = 0;
+        size_t i = start;
+
+        if (COMBINERS.contains(tokens[i])) {
+            const std::string& alias = tokens[i++];
+            const Combiner& combiner = COMBINERS.at(alias);
+            std::vector<size_t> inputs;
+
+            for (size_t j = 0; j != combiner.inputs; ++j, ++i) {
+                if (i == tokens.size() || !names_.contains(tokens[i])) {
+                    throw InvalidGraphError{line};
+                }
+
+                inputs.push_back(names_.at(tokens[i]));
+            }
+
+            std::queue<std::string> parameters;
+            std::string operation = alias;
+            for (; i != tokens.size() && !IsAlias(tokens[i]); ++i) {
+                parameters.push(tokens[i]);
+                operation += ' ' + tokens[i];
+            }
+
+            vertex = Add({combiner.parse(std::move(parameters)), inputs}, operation);
+        } else {
+            vertex = AddSource(tokens[i++], line);
+        }
+
+        // -roi and -mask scope the filter after them, the mask is the second input of the filter
+        std::optional<std::variant<RegionFilter::Parameters, MaskedFilter::Parameters>> scope;
+        std::optional<size_t> mask;
+        std::string scope_operation;
+
+        while (i != tokens.size()) {
+            if (!IsAlias(tokens[i])) {
+                throw InvalidGraphError{line};
+            }
+
+            const std::string& alias = tokens[i++];
+            std::queue<std::string> parameters;
+            std::string operation = alias;
+            for (; i != tokens.size() && !IsAlias(tokens[i]); ++i) {
+                parameters.push(tokens[i]);
+                operation += ' ' + tokens[i];
+            }
+
+            if (alias == RegionFilter::ALIAS || alias == MaskedFilter::ALIAS) {
+                if (scope.has_value()) {
+                    throw InvalidGraphError{line};
+                }
+
+                if (alias == RegionFilter::ALIAS) {
+                    scope = RegionFilter::ParseParameters(std::move(parameters));
+                    scope_operation = operation + ' ';
+                } else {
+                    MaskedFilter::Parameters masked = MaskedFilter::ParseParameters(std::move(parameters));
+                    mask = AddSource(masked.path, line);
+                    masked.path.clear();
+                    scope = std::move(masked);
+                    scope_operation = alias + ' ';
+                }
+                continue;
+            }
+
+            FilterNode filter = pipeline::ParseFilter(alias, std::move(parameters));
+            std::vector<size_t> inputs{vertex};
+
+            if (scope.has_value()) {
+                filter = std::visit([&filter](const auto& scoped) { return pipeline::Restrict(scoped, filter); },
+                                    *scope);
+                operation = scope_operation + operation;
+                scope.reset();
+            }
+            if (mask.has_value()) {
+                inputs.push_back(*mask);
+                mask.reset();
+            }
+
+            vertex = Add({std::move(filter), inputs}, operation);
+        }
+
+        if (scope.has_value()) {
+            throw InvalidGraphError{line};
+        }
+
+        return vertex;
+    }
+
+    void AddLine(const std::vector<std::string>& tokens, size_t line) {
+        if (tokens.front() == SAVE_KEYWORD) {
+            if (tokens.size() != 3 || !names_.contains(tokens[1])) {
+                throw InvalidGraphError{line};
+            }
+            if (!image_io::IsSupported(tokens[2])) {
+                throw UnsupportedFileFormat{tokens[2]};
+            }
+
+            graph_.outputs.emplace_back(names_.at(tokens[1]), tokens[2]);
+            return;
+        }
+
+        if (tokens.size() < 3 || !IsName(tokens[0]) || tokens[1] != ASSIGNMENT || names_.contains(tokens[0])) {
+            throw InvalidGraphError{line};
+        }
+
+        names_[tokens[0]] = AddExpression(tokens, 2, line);
+    }
+
+    Graph Release() {
+        return std::move(graph_);
+    }
+};
+
+std::unique_ptr<Image> Compute(const Vertex& vertex, std::vector<std::unique_ptr<Image>>& images,
+                               std::vector<int64_t>& uses) {
+    if (const auto* source = std::get_if<SourceNode>(&vertex.operation)) {
+        return std::unique_ptr<Image>(image_io::ReadFile(source->path, nullptr));
+    }
+
+    // the last consumer of the first input takes its image, the others work on a copy
+    const size_t first = vertex.inputs.front();
+    std::unique_ptr<Image> img = uses[first] == 1 ? std::move(images[first]) : std::make_unique<Image>(*images[first]);
+
+    std::vector<const Image*> others;
+    for (size_t i = 1; i != vertex.inputs.size(); ++i) {
+        others.push_back(images[vertex.inputs[i]].get());
+    }
+
+    if (const auto* filter = std::get_if<FilterNode>(&vertex.operation)) {
+        if (others.empty()) {
+            pipeline::Apply(*filter, *img);
+        } else {
+            // the second input is the mask of -mask, it stays owned by the graph
+            MaskedFilter::Parameters parameters = std::get<Node<MaskedFilter>>(*filter).parameters;
+            parameters.mask = std::shared_ptr<const Image>(std::shared_ptr<const Image>(), others.front());
+            MaskedFilter().Apply(*img, parameters);
+        }
+    } else {
+        std::visit(
+            [&img, &others](const auto& node) {
+                using Filter = typename std::decay_t<decltype(node)>::Filter;
+                Filter().Apply(*img, others, node.parameters);
+            },
+            std::get<CombiningNode>(vertex.operation));
+    }
+
+    for (size_t input : vertex.inputs) {
+        if (--uses[input] == 0) {
+            images[input].reset();
+        }
+    }
+
+    return img;
+}
+}  // namespace
+
+Graph graph::Parse(std::istream& description) {
+    GraphBuilder builder;
+    std::string text;
+
+    for (size_t line = 1; std::getline(description, text); ++line) {
+        std::istringstream words(text);
+        const std::vector<std::string> tokens{std::istream_iterator<std::string>(words),
+                                              std::istream_iterator<std::string>()};
+
+        if (!tokens.empty() && tokens.front()[0] != COMMENT) {
+            builder.AddLine(tokens, line);
+        }
+    }
+
+    return builder.Release();
+}
+
+Graph graph::ParseFile(const std::string& file_path) {
+    if (file_path == image_io::STANDARD_STREAM) {
+        return Parse(std::cin);
+    }
+
+    std::ifstream f(file_path);
+
+    if (!f.is_open()) {
+        throw FileNotFoundError{};
+    }
+
+    return Parse(f);
+}
+
+void graph::Run(const Graph& graph) {
+    const std::vector<Vertex>& vertices = graph.vertices;
+
+    // only the vertices the outputs depend on are computed, every vertex counts the vertices that still need it
+    std::vector<bool> needed(vertices.size());
+    std::vector<int64_t> uses(vertices.size());
+    std::multimap<size_t, std::string> outputs;
+
+    for (const auto& [vertex, path] : graph.outputs) {
+        needed[vertex] = true;
+        outputs.emplace(vertex, path);
+    }
+
+    for (size_t vertex = vertices.size(); vertex-- != 0;) {
+        if (needed[vertex]) {
+            for (size_t input : vertices[vertex].inputs) {
+                needed[input] = true;
+                ++uses[input];
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Image>> images(vertices.size());
+
+    for (size_t vertex = 0; vertex != vertices.size(); ++vertex) {
+        if (!needed[vertex]) {
+            continue;
+        }
+
+        images[vertex] = Compute(vertices[vertex], images, uses);
+
+        const auto [begin, end] = outputs.equal_range(vertex);
+        for (auto output = begin; output != end; ++output) {
+            image_io::SaveFile(output->second, images[vertex].get());
+        }
+
+        if (uses[vertex] == 0) {
+            images[vertex].reset();
+        }
+    }
+}
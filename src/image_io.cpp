@@ -0,0 +1,203 @@
+#include "../utils/image_io.h"
+#include "../utils/bmp_reader.h"
+#include "../utils/ipt_reader.h"
+#include "../utils/pfm_reader.h"
+#include "../utils/pnm_reader.h"
+#include "../utils/qoi_reader.h"
+#include "../utils/tiff_reader.h"
+#include "../utils/yuv_reader.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+
+namespace {
+using namespace std::string_literals;
+
+const std::string DEFAULT_OUTPUT_FORMAT = ".bmp";
+
+struct Codec {
+    Image* (*read)(const std::string&, Image*, const ReadOptions&);
+    void (*save)(const std::string&, Image*, const WriteOptions&);
+
+    // the extension tells the stream functions of codecs with several formats which one is used
+    Image* (*read_stream)(std::istream&, Image*, const ReadOptions&, const std::string&);
+    void (*save_stream)(std::ostream&, Image*, const WriteOptions&, const std::string&);
+};
+
+// adapters of the stream functions of codecs with a single format
+template <Image* (*Read)(std::istream&, Image*, const ReadOptions&)>
+Image* ReadStream(std::istream& f, Image* img, const ReadOptions& options, const std::string&) {
+    return Read(f, img, options);
+}
+
+template <void (*Save)(std::ostream&, Image*, const WriteOptions&)>
+void SaveStream(std::ostream& f, Image* img, const WriteOptions& options, const std::string&) {
+    Save(f, img, options);
+}
+
+const Codec BMP{bmp_reader::ReadFile, bmp_reader::SaveFile, ReadStream<bmp_reader::ReadStream>,
+                SaveStream<bmp_reader::SaveStream>};
+const Codec QOI{qoi_reader::ReadFile, qoi_reader::SaveFile, ReadStream<qoi_reader::ReadStream>,
+                SaveStream<qoi_reader::SaveStream>};
+const Codec PNM{pnm_reader::ReadFile, pnm_reader::SaveFile, ReadStream<pnm_reader::ReadStream>,
+                pnm_reader::SaveStream};
+const Codec PFM{pfm_reader::ReadFile, pfm_reader::SaveFile, ReadStream<pfm_reader::ReadStream>,
+                SaveStream<pfm_reader::SaveStream>};
+const Codec TIFF{tiff_reader::ReadFile, tiff_reader::SaveFile, ReadStream<tiff_reader::ReadStream>,
+                 tiff_reader::SaveStream};
+const Codec YUV{yuv_reader::ReadFile, yuv_reader::SaveFile, yuv_reader::ReadStream, yuv_reader::SaveStream};
+const Codec IPT{ipt_reader::ReadFile, ipt_reader::SaveFile, ReadStream<ipt_reader::ReadStream>,
+                SaveStream<ipt_reader::SaveStream>};
+
+const std::map<std::string, Codec> CODECS{{".bmp", BMP},  {".qoi", QOI},  {".pgm", PNM},  {".ppm", PNM},
+                                          {".pam", PNM},  {".pnm", PNM},  {".pfm", PFM},  {".tif", TIFF},
+                                          {".tiff", TIFF}, {".btf", TIFF}, {".yuv", YUV}, {".nv12", YUV},
+                                          {".ipt", IPT}};
+
+// raw frames have no signature, so their format has to be given
+const std::vector<std::pair<std::string, std::string>> SIGNATURES{
+    {"BM", ".bmp"},      {"qoif", ".qoi"},    {"P5", ".pnm"},      {"P6", ".pnm"},
+    {"P7", ".pnm"},      {"PF", ".pfm"},      {"Pf", ".pfm"},      {"II*\0"s, ".tif"},
+    {"MM\0*"s, ".tif"},  {"II+\0"s, ".tif"},  {"MM\0+"s, ".tif"},  {"IPTILES\0"s, ".ipt"}};
+const size_t SIGNATURE_SIZE = 8;
+
+const Codec& FindCodec(const std::string& file_path) {
+    const auto codec = CODECS.find(std::filesystem::path(file_path).extension().string());
+
+    if (codec == CODECS.end()) {
+        throw UnsupportedFileFormat{file_path};
+    }
+
+    return codec->second;
+}
+
+const Codec& FindFormat(const std::string& extension) {
+    const auto codec = CODECS.find(extension);
+
+    if (codec == CODECS.end()) {
+        throw UnsupportedFileFormat{extension};
+    }
+
+    return codec->second;
+}
+
+// Standard input, which may be a pipe. Seeking forward skips bytes, seeking back is possible only
+// within the last read block, which is enough to read the signature twice.
+class InputBuffer : public std::streambuf {
+private:
+    static const size_t BLOCK_SIZE = 1 << 16;
+
+    std::FILE* file_;
+    std::vector<char> block_;
+    std::streamoff block_offset_ = 0;  // position of the first byte of the block in the stream
+
+protected:
+    int_type underflow() override {
+        if (gptr() == egptr()) {
+            block_offset_ += egptr() - eback();
+            const size_t size = std::fread(block_.data(), 1, BLOCK_SIZE, file_);
+            setg(block_.data(), block_.data(), block_.data() + size);
+
+            if (size == 0) {
+                return traits_type::eof();
+            }
+        }
+
+        return traits_type::to_int_type(*gptr());
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override {
+        if (direction == std::ios_base::cur) {
+            return seekpos(block_offset_ + (gptr() - eback()) + offset, which);
+        }
+        if (direction == std::ios_base::beg) {
+            return seekpos(offset, which);
+        }
+
+        return pos_type(off_type(-1));
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+        const std::streamoff target = position;
+
+        if (!(which & std::ios_base::in) || target < block_offset_) {
+            return pos_type(off_type(-1));
+        }
+
+        while (target > block_offset_ + (egptr() - eback())) {
+            setg(eback(), egptr(), egptr());
+
+            if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+                return pos_type(off_type(-1));
+            }
+        }
+
+        setg(eback(), eback() + (target - block_offset_), egptr());
+        return position;
+    }
+
+public:
+    explicit InputBuffer(std::FILE* file) : file_(file), block_(BLOCK_SIZE) {
+    }
+};
+
+std::string DetectFormat(std::istream& f) {
+    std::string signature(SIGNATURE_SIZE, '\0');
+    f.read(signature.data(), SIGNATURE_SIZE);
+    f.clear();
+    f.seekg(0);
+
+    for (const auto& [prefix, extension] : SIGNATURES) {
+        if (signature.starts_with(prefix)) {
+            return extension;
+        }
+    }
+
+    throw UnsupportedFileFormat{"Input stream"};
+}
+}  // namespace
+
+bool image_io::IsSupported(const std::string& file_path) {
+    return file_path == STANDARD_STREAM || CODECS.contains(std::filesystem::path(file_path).extension().string());
+}
+
+bool image_io::IsFormatSupported(const std::string& extension) {
+    return CODECS.contains(extension);
+}
+
+Image* image_io::ReadFile(const std::string& file_path, Image* img, const ReadOptions& options) {
+    if (file_path != STANDARD_STREAM) {
+        return FindCodec(file_path).read(file_path, img, options);
+    }
+
+    InputBuffer buffer(stdin);
+    std::istream f(&buffer);
+    const std::string format = options.format.empty() ? DetectFormat(f) : options.format;
+
+    return FindFormat(format).read_stream(f, img, options, format);
+}
+
+std::string image_io::OutputFormat(const std::string& output_path, const WriteOptions& options) {
+    if (output_path != STANDARD_STREAM) {
+        return std::filesystem::path(output_path).extension().string();
+    }
+
+    return options.format.empty() ? DEFAULT_OUTPUT_FORMAT : options.format;
+}
+
+void image_io::SaveFile(const std::string& output_path, Image* img, const WriteOptions& options) {
+    if (output_path != STANDARD_STREAM) {
+        FindCodec(output_path).save(output_path, img, options);
+        return;
+    }
+
+    const std::string format = OutputFormat(output_path, options);
+    FindFormat(format).save_stream(std::cout, img, options, format);
+    std::cout.flush();
+
+    if (!std::cout) {
+        throw FileCreationError{};
+    }
+}
@@ -0,0 +1,293 @@
+#include "../utils/ipt_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+const char MAGIC[8] = "IPTILES";
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint32_t DEFAULT_TILE_SIZE = 256;
+const int64_t MAX_TILE_SIZE = 1 << 15;
+const int64_t CHANNELS = 3;
+
+struct Header {
+    char magic[8];
+    uint32_t byte_order;  // files written on hosts with another byte order are rejected
+    uint32_t tile_size;
+    int64_t width;
+    int64_t height;
+    uint64_t horizontal_resolution;
+    uint64_t vertical_resolution;
+    uint32_t color_mode;
+    uint32_t reserved;
+    uint64_t index_offset;  // offsets of all tiles, 0 if the tiles are stored in order
+};
+
+static_assert(sizeof(Header) == 64);
+
+// read-only mapping of the whole file, pages are loaded when they are touched
+class MappedFile {
+private:
+    int descriptor_;
+    size_t size_;
+    const uint8_t* data_;
+
+public:
+    explicit MappedFile(const std::string& file_path) {
+        descriptor_ = open(file_path.c_str(), O_RDONLY);
+
+        if (descriptor_ < 0) {
+            throw FileNotFoundError{};
+        }
+
+        struct stat status {};
+        void* data = MAP_FAILED;
+
+        if (fstat(descriptor_, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(Header))) {
+            size_ = status.st_size;
+            data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor_, 0);
+        }
+
+        if (data == MAP_FAILED) {
+            close(descriptor_);
+            throw UnsupportedFileFormat{file_path};
+        }
+
+        // region reads jump between tiles, so reading ahead is useless
+        madvise(data, size_, MADV_RANDOM);
+        data_ = static_cast<const uint8_t*>(data);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        close(descriptor_);
+    }
+
+    const uint8_t* Data() const {
+        return data_;
+    }
+
+    size_t Size() const {
+        return size_;
+    }
+};
+
+uint64_t TileBytes(uint64_t tile_size) {
+    return tile_size * tile_size * CHANNELS * sizeof(double);
+}
+
+// tiles larger than the image rounded up to the default tile size only store zeros
+int64_t MaxTileSize(int64_t height, int64_t width) {
+    const int64_t side =
+        (std::max({height, width, int64_t{1}}) + DEFAULT_TILE_SIZE - 1) / DEFAULT_TILE_SIZE * DEFAULT_TILE_SIZE;
+    return std::min(side, MAX_TILE_SIZE);
+}
+
+// copies the tile at top, left, the part outside the image is filled with zeros
+void GatherTile(Image* img, int64_t top, int64_t left, int64_t tile_size, std::vector<double>& tile) {
+    auto [height, width] = img->Shape();
+    std::fill(tile.begin(), tile.end(), 0.);
+
+    for (int64_t y = top; y != std::min(top + tile_size, height); ++y) {
+        for (int64_t x = left; x != std::min(left + tile_size, width); ++x) {
+            const Pixel& pixel = img->GetPixels()[y][x];
+            double* sample = &tile[CHANNELS * ((y - top) * tile_size + x - left)];
+            sample[0] = pixel.r;
+            sample[1] = pixel.g;
+            sample[2] = pixel.b;
+        }
+    }
+}
+
+bool IsUniform(const std::vector<double>& tile) {
+    for (size_t i = CHANNELS; i != tile.size(); ++i) {
+        if (tile[i] != tile[i % CHANNELS]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Image* Decode(const uint8_t* data, size_t size, const ReadOptions& options, const std::string& name) {
+    Header header{};
+
+    if (size < sizeof(Header)) {
+        throw UnsupportedFileFormat{name};
+    }
+
+    std::memcpy(&header, data, sizeof(Header));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.byte_order != BYTE_ORDER_MARK) {
+        throw UnsupportedFileFormat{name};
+    }
+    CheckRasterSize(header.height, header.width, CHANNELS * sizeof(double), "IPT");
+
+    if (header.tile_size == 0 || header.tile_size > MaxTileSize(header.height, header.width) ||
+        header.color_mode > static_cast<uint32_t>(ColorMode::monochrome)) {
+        throw UnsupportedFileFormat{"Wrong IPT header"};
+    }
+
+    const int64_t tile_size = header.tile_size;
+    const int64_t tiles_across = (header.width + tile_size - 1) / tile_size;
+    const uint64_t tiles_count = tiles_across * ((header.height + tile_size - 1) / tile_size);
+    const uint64_t tile_bytes = TileBytes(tile_size);
+
+    // every tile takes at least its offset in the file, so the offsets are not allocated for a truncated file;
+    // sizes are compared as differences, which can not wrap
+    const uint64_t body_size = size - sizeof(Header);
+    if (tiles_count > body_size / sizeof(uint64_t)) {
+        throw UnsupportedFileFormat{"Truncated raster"};
+    }
+
+    std::vector<uint64_t> offsets(tiles_count);
+    if (header.index_offset == 0) {
+        if (tiles_count > body_size / tile_bytes) {
+            throw UnsupportedFileFormat{"Truncated raster"};
+        }
+
+        for (uint64_t i = 0; i != tiles_count; ++i) {
+            offsets[i] = sizeof(Header) + i * tile_bytes;
+        }
+    } else {
+        if (header.index_offset > size || tiles_count * sizeof(uint64_t) > size - header.index_offset) {
+            throw UnsupportedFileFormat{"Truncated IPT index"};
+        }
+
+        std::memcpy(offsets.data(), data + header.index_offset, tiles_count * sizeof(uint64_t));
+    }
+
+    for (uint64_t offset : offsets) {
+        if (offset < sizeof(Header) || offset > size || tile_bytes > size - offset) {
+            throw UnsupportedFileFormat{"Truncated raster"};
+        }
+    }
+
+    ImageBuilder builder(header.height, header.width, header.horizontal_resolution, header.vertical_resolution,
+                         options);
+    const Region& source = builder.Source();
+    std::vector<double> rgb(CHANNELS * source.width);
+
+    // rows of the source are gathered from the rows of the tiles they cross
+    for (int64_t y = source.top; y != source.top + source.height; ++y) {
+        if (!builder.IsRowNeeded(y)) {
+            continue;
+        }
+
+        for (int64_t x = source.left; x < source.left + source.width; x = (x / tile_size + 1) * tile_size) {
+            const int64_t columns = std::min((x / tile_size + 1) * tile_size, source.left + source.width) - x;
+            const uint8_t* tile = data + offsets[y / tile_size * tiles_across + x / tile_size];
+            const uint64_t pixel = (y % tile_size) * tile_size + x % tile_size;
+
+            std::memcpy(&rgb[CHANNELS * (x - source.left)], tile + pixel * CHANNELS * sizeof(double),
+                        columns * CHANNELS * sizeof(double));
+        }
+
+        builder.AddRow(y, rgb.data(), 1.0);
+    }
+
+    return builder.Release(static_cast<ColorMode>(header.color_mode));
+}
+}  // namespace
+
+Image* ipt_reader::ReadFile(const std::string& file_path, Image* img, const ReadOptions& options) {
+    const MappedFile file(file_path);
+    return Decode(file.Data(), file.Size(), options, file_path);
+}
+
+Image* ipt_reader::ReadStream(std::istream& f, Image* img, const ReadOptions& options) {
+    // tiles are read in any order, so the stream is kept in memory
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    return Decode(data.data(), data.size(), options, "Input stream");
+}
+
+void ipt_reader::SaveFile(const std::string& output_path, Image* img, const WriteOptions& options) {
+    std::fstream f;
+    f.open(output_path, std::ios::out | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileCreationError{};
+    }
+
+    SaveStream(f, img, options);
+    f.close();
+}
+
+void ipt_reader::SaveStream(std::ostream& f, Image* img, const WriteOptions& options) {
+    auto [height, width] = img->Shape();
+    auto [horizontal_resolution, vertical_resolution] = img->Resolution();
+    const int64_t tile_size =
+        std::min(options.tile_size > 0 ? options.tile_size : DEFAULT_TILE_SIZE, MaxTileSize(height, width));
+    std::vector<double> tile(tile_size * tile_size * CHANNELS);
+
+    // the first pass places the tiles, uniform tiles like flat backgrounds are written only once
+    std::map<std::tuple<double, double, double>, uint64_t> uniform_tiles;
+    std::vector<uint64_t> offsets;
+    std::vector<bool> written;
+    uint64_t offset = sizeof(Header);
+
+    for (int64_t top = 0; top < height; top += tile_size) {
+        for (int64_t left = 0; left < width; left += tile_size) {
+            GatherTile(img, top, left, tile_size, tile);
+
+            if (IsUniform(tile)) {
+                const auto [uniform_tile, inserted] = uniform_tiles.try_emplace({tile[0], tile[1], tile[2]}, offset);
+
+                if (!inserted) {
+                    offsets.push_back(uniform_tile->second);
+                    written.push_back(false);
+                    continue;
+                }
+            }
+
+            offsets.push_back(offset);
+            written.push_back(true);
+            offset += TileBytes(tile_size);
+        }
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.byte_order = BYTE_ORDER_MARK;
+    header.tile_size = tile_size;
+    header.width = width;
+    header.height = height;
+    header.horizontal_resolution = horizontal_resolution;
+    header.vertical_resolution = vertical_resolution;
+    header.color_mode = static_cast<uint32_t>(img->GetColorMode());
+
+    // the index is needed only when some tiles are shared
+    const bool indexed = offset != sizeof(Header) + offsets.size() * TileBytes(tile_size);
+    if (indexed) {
+        header.index_offset = offset;
+    }
+
+    // the second pass writes the tiles in order, so the output is never seeked and can be a pipe
+    f.write(reinterpret_cast<char*>(&header), sizeof(Header));
+
+    size_t i = 0;
+    for (int64_t top = 0; top < height; top += tile_size) {
+        for (int64_t left = 0; left < width; left += tile_size) {
+            if (written[i++]) {
+                GatherTile(img, top, left, tile_size, tile);
+                f.write(reinterpret_cast<char*>(tile.data()),
+                        static_cast<std::streamsize>(tile.size() * sizeof(double)));
+            }
+        }
+    }
+
+    if (indexed) {
+        f.write(reinterpret_cast<char*>(offsets.data()),
+                static_cast<std::streamsize>(offsets.size() * sizeof(uint64_t)));
+    }
+}
@@ -0,0 +1,105 @@
+#include "../utils/lazy_image.h"
+#include "../utils/image_io.h"
+
+#include <limits>
+
+struct LazyImage::Expression {
+    std::shared_ptr<const Expression> input;
+    std::optional<FilterNode> filter;  // empty for sources
+
+    // sources are either files or images in memory
+    std::string file_path;
+    ReadOptions read_options;
+    std::shared_ptr<const Image> img;
+};
+
+LazyImage LazyImage::Read(const std::string& file_path, const ReadOptions& options) {
+    return LazyImage(std::make_shared<const Expression>(Expression{nullptr, std::nullopt, file_path, options, nullptr}));
+}
+
+LazyImage LazyImage::FromImage(const Image& img) {
+    return LazyImage(
+        std::make_shared<const Expression>(Expression{nullptr, std::nullopt, {}, {}, std::make_shared<Image>(img)}));
+}
+
+LazyImage LazyImage::FromImage(std::shared_ptr<const Image> img) {
+    return LazyImage(std::make_shared<const Expression>(Expression{nullptr, std::nullopt, {}, {}, std::move(img)}));
+}
+
+LazyImage LazyImage::Apply(const FilterNode& filter) const {
+    return LazyImage(std::make_shared<const Expression>(Expression{expression_, filter, {}, {}, nullptr}));
+}
+
+Image* LazyImage::Evaluate(const Expression& expression, int64_t needed_height, int64_t needed_width) {
+    if (expression.img != nullptr) {
+        auto [height, width] = expression.img->Shape();
+        auto [horizontal_resolution, vertical_resolution] = expression.img->Resolution();
+        const int64_t new_height = std::min(height, needed_height);
+        const int64_t new_width = std::min(width, needed_width);
+
+        // rows are copy-constructed, which copies the pixels without clamping them again
+        std::vector<std::vector<Pixel>> rows;
+        rows.reserve(new_height);
+        for (int64_t y = 0; y != new_height; ++y) {
+            const std::vector<Pixel>& row = expression.img->GetPixels()[y];
+            rows.emplace_back(row.begin(), row.begin() + new_width);
+        }
+
+        Image* img = new Image(0, 0, horizontal_resolution, vertical_resolution);
+        img->GetPixels() = std::move(rows);
+        img->Reshape(new_height, new_width);
+        img->SetColorMode(expression.img->GetColorMode());
+
+        return img;
+    }
+
+    if (!expression.filter.has_value()) {
+        // crops keep the top left corner, so only the top left part of the window is read
+        ReadOptions options = expression.read_options;
+        const Region window = options.window.value_or(
+            Region{0, 0, std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::max()});
+        options.window =
+            Region{window.top, window.left, std::min(window.height, needed_height), std::min(window.width, needed_width)};
+
+        Image* img = nullptr;
+        return image_io::ReadFile(expression.file_path, img, options);
+    }
+
+    const FilterNode& filter = *expression.filter;
+    Image* img = nullptr;
+
+    if (std::holds_alternative<Node<CropFilter>>(filter)) {
+        auto [width, height] = std::get<Node<CropFilter>>(filter).parameters;
+        img = Evaluate(*expression.input, std::min(needed_height, height), std::min(needed_width, width));
+    } else {
+        // stencils read the pixels around the needed part of their input
+        const int64_t radius = pipeline::Radius(filter);
+        img = Evaluate(*expression.input, needed_height + radius, needed_width + radius);
+
+        // readers which return only brightness have already applied a grayscale filter
+        const Expression& input = *expression.input;
+        if (std::holds_alternative<Node<GrayscaleFilter>>(filter) && input.read_options.luma_only &&
+            !input.filter.has_value() && input.img == nullptr && img->GetColorMode() == ColorMode::grayscale) {
+            return img;
+        }
+    }
+
+    try {
+        pipeline::Apply(filter, *img);
+    } catch (...) {
+        delete img;
+        throw;
+    }
+
+    return img;
+}
+
+Image* LazyImage::Materialize() const {
+    const int64_t whole = std::numeric_limits<int64_t>::max() / 2;
+    return Evaluate(*expression_, whole, whole);
+}
+
+void LazyImage::SaveFile(const std::string& output_path, const WriteOptions& options) const {
+    std::unique_ptr<Image> img(Materialize());
+    image_io::SaveFile(output_path, img.get(), options);
+}
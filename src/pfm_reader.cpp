@@ -0,0 +1,162 @@
+#include "../utils/pfm_reader.h"
+
+#include <bit>
+#include <cctype>
+
+namespace {
+const uint8_t BYTE = 8;
+const uint8_t SAMPLE_SIZE = 4;
+const uint32_t BYTE_MASK = UINT8_MAX;
+
+struct Header {
+    int64_t width;
+    int64_t height;
+    int64_t channels;
+    bool little_endian;  // negative scale
+};
+
+Header ParseHeader(std::istream& f, const std::string& file_path) {
+    Header header{};
+    char magic[2];
+    f.read(magic, 2);
+
+    if (!f || magic[0] != 'P' || (magic[1] != 'F' && magic[1] != 'f')) {
+        throw UnsupportedFileFormat{file_path};
+    }
+
+    header.channels = magic[1] == 'F' ? 3 : 1;
+
+    double scale = 0;
+    f >> header.width >> header.height >> scale;
+    const int separator = f.get();  // single whitespace before the raster
+
+    if (!f || header.width <= 0 || header.height <= 0 || scale == 0 || !std::isspace(separator)) {
+        throw UnsupportedFileFormat{"Wrong PFM header"};
+    }
+
+    CheckRemainingBytes(f, CheckRasterSize(header.height, header.width, header.channels * SAMPLE_SIZE, "PFM"));
+
+    header.little_endian = scale < 0;
+
+    return header;
+}
+
+float DecodeSample(const uint8_t* bytes, bool little_endian) {
+    uint32_t bits = 0;
+
+    for (uint8_t i = 0; i != SAMPLE_SIZE; ++i) {
+        bits = (bits << BYTE) | bytes[little_endian ? SAMPLE_SIZE - 1 - i : i];
+    }
+
+    return std::bit_cast<float>(bits);
+}
+
+void EncodeSample(double color, uint8_t* bytes) {
+    const auto bits = std::bit_cast<uint32_t>(static_cast<float>(color));
+
+    for (uint8_t i = 0; i != SAMPLE_SIZE; ++i) {
+        bytes[i] = (bits >> (BYTE * i)) & BYTE_MASK;
+    }
+}
+}  // namespace
+
+namespace {
+Image* Decode(std::istream& f, Image* img, const ReadOptions& options, const std::string& name) {
+    const Header header = ParseHeader(f, name);
+    const std::streamoff raster_offset = f.tellg();
+
+    ImageBuilder builder(header.height, header.width, 0, 0, options);
+    const Region& source = builder.Source();
+
+    const int64_t pixel_size = header.channels * SAMPLE_SIZE;
+    std::vector<uint8_t> row(source.width * pixel_size);
+    std::vector<float> rgb(3 * source.width);
+
+    // rows are stored from the bottom to the top and visited in the file order, so the file is only seeked forward
+    for (int64_t y = source.top + source.height - 1; y >= source.top; --y) {
+        if (!builder.IsRowNeeded(y)) {
+            continue;
+        }
+
+        f.seekg(raster_offset + ((header.height - 1 - y) * header.width + source.left) * pixel_size);
+        f.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row.size()));
+
+        if (!f) {
+            throw UnsupportedFileFormat{"Truncated raster"};
+        }
+
+        for (int64_t x = 0; x != source.width; ++x) {
+            for (int64_t c = 0; c != 3; ++c) {
+                const uint8_t* sample = &row[x * pixel_size + (header.channels == 1 ? 0 : c) * SAMPLE_SIZE];
+                rgb[3 * x + c] = DecodeSample(sample, header.little_endian);
+            }
+        }
+
+        builder.AddRow(y, rgb.data(), 1.0);
+    }
+
+    img = builder.Release();
+
+    if (header.channels == 1) {
+        img->SetColorMode(ColorMode::grayscale);
+    }
+
+    return img;
+}
+}  // namespace
+
+Image* pfm_reader::ReadFile(const std::string& file_path, Image* img, const ReadOptions& options) {
+    std::ifstream f;
+    f.open(file_path, std::ios::in | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileNotFoundError{};
+    }
+
+    return Decode(f, img, options, file_path);
+}
+
+Image* pfm_reader::ReadStream(std::istream& f, Image* img, const ReadOptions& options) {
+    return Decode(f, img, options, "Input stream");
+}
+
+void pfm_reader::SaveFile(const std::string& output_path, Image* img, const WriteOptions& options) {
+    std::fstream f;
+    f.open(output_path, std::ios::out | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileCreationError{};
+    }
+
+    SaveStream(f, img, options);
+    f.close();
+}
+
+void pfm_reader::SaveStream(std::ostream& f, Image* img, const WriteOptions& options) {
+    auto [height, width] = img->Shape();
+
+    ColorDepth depth = options.depth;
+    if (depth == ColorDepth::automatic) {
+        depth = DetectColorDepth(*img);
+    }
+
+    const int64_t channels = depth == ColorDepth::rgb ? 3 : 1;
+
+    // negative scale marks little endian samples
+    f << "P" << (channels == 3 ? 'F' : 'f') << "\n" << width << " " << height << "\n-1.0\n";
+
+    std::vector<uint8_t> row(width * channels * SAMPLE_SIZE);
+    for (int64_t y = height - 1; y >= 0; --y) {
+        uint8_t* sample = row.data();
+
+        for (const Pixel& pixel : img->GetPixels()[y]) {
+            const double colors[] = {pixel.r, pixel.g, pixel.b};
+
+            for (int64_t c = 0; c != channels; ++c, sample += SAMPLE_SIZE) {
+                EncodeSample(channels == 1 ? GrayLevel(pixel) : colors[c], sample);
+            }
+        }
+
+        f.write(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+}
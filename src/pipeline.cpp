@@ -0,0 +1,586 @@
+#include "../utils/pipeline.h"
+#include "../utils/console_interface.h"
+#include "../utils/image_io.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <optional>
+#include <sstream>
+
+namespace {
+const std::string SCALE_OPTION = "--scale";
+const std::string FAST_SCALE_OPTION = "--fast-scale";
+const std::string DEPTH_OPTION = "--depth";
+const std::string SAMPLE_BITS_OPTION = "--sample-bits";
+const std::string TILE_SIZE_OPTION = "--tile-size";
+const std::string FRAME_SIZE_OPTION = "--frame-size";
+const std::string MATRIX_OPTION = "--matrix";
+const std::string INPUT_FORMAT_OPTION = "--input-format";
+const std::string OUTPUT_FORMAT_OPTION = "--output-format";
+const std::string OUTPUT_OPTION = "-o";
+const int64_t TILE_ALIGNMENT = 16;
+
+template <typename Filter>
+FilterNode MakeNode(std::queue<std::string> parameters) {
+    return Node<Filter>{Filter::ParseParameters(std::move(parameters))};
+}
+
+const std::map<std::string, FilterNode (*)(std::queue<std::string>)> FILTER_PARSERS{
+    {CropFilter::ALIAS, MakeNode<CropFilter>},
+    {GrayscaleFilter::ALIAS, MakeNode<GrayscaleFilter>},
+    {NegativeFilter::ALIAS, MakeNode<NegativeFilter>},
+    {SharpeningFilter::ALIAS, MakeNode<SharpeningFilter>},
+    {EdgeDetectionFilter::ALIAS, MakeNode<EdgeDetectionFilter>},
+    {GaussianBlurFilter::ALIAS, MakeNode<GaussianBlurFilter>}};
+
+int64_t ParseScale(std::queue<std::string> parameters) {
+    if (parameters.size() != 1) {
+        throw InvalidArgumentsError{};
+    }
+
+    try {
+        int64_t scale = std::stol(parameters.front());
+        if (scale == 1 || scale == 2 || scale == 4 || scale == 8) {  // NOLINT
+            return scale;
+        }
+    } catch (const std::invalid_argument& e) {
+    }
+
+    throw InvalidArgumentsError{};
+}
+
+ColorDepth ParseDepth(std::queue<std::string> parameters) {
+    const std::map<std::string, ColorDepth> depths{{"auto", ColorDepth::automatic},
+                                                   {"24", ColorDepth::rgb},
+                                                   {"8", ColorDepth::grayscale},
+                                                   {"1", ColorDepth::monochrome}};
+
+    if (parameters.size() != 1 || !depths.contains(parameters.front())) {
+        throw InvalidArgumentsError{};
+    }
+
+    return depths.at(parameters.front());
+}
+
+uint8_t ParseSampleBits(std::queue<std::string> parameters) {
+    if (parameters.size() != 1 || (parameters.front() != "8" && parameters.front() != "16")) {
+        throw InvalidArgumentsError{};
+    }
+
+    return static_cast<uint8_t>(std::stoi(parameters.front()));
+}
+
+int64_t ParseTileSize(std::queue<std::string> parameters) {
+    if (parameters.size() != 1) {
+        throw InvalidArgumentsError{};
+    }
+
+    try {
+        int64_t tile_size = std::stol(parameters.front());
+        if (tile_size > 0 && tile_size % TILE_ALIGNMENT == 0) {
+            return tile_size;
+        }
+    } catch (const std::invalid_argument& e) {
+    } catch (const std::out_of_range& e) {
+    }
+
+    throw InvalidArgumentsError{};
+}
+
+std::tuple<int64_t, int64_t> ParseFrameSize(std::queue<std::string> parameters) {
+    if (parameters.size() != 2) {
+        throw InvalidArgumentsError{};
+    }
+
+    try {
+        const int64_t width = std::stol(parameters.front());
+        parameters.pop();
+        const int64_t height = std::stol(parameters.front());
+
+        if (width > 0 && height > 0) {
+            return std::make_tuple(width, height);
+        }
+    } catch (const std::invalid_argument& e) {
+    } catch (const std::out_of_range& e) {
+    }
+
+    throw InvalidArgumentsError{};
+}
+
+YuvMatrix ParseMatrix(std::queue<std::string> parameters) {
+    const std::map<std::string, YuvMatrix> matrices{{"601", YuvMatrix::bt601}, {"709", YuvMatrix::bt709}};
+
+    if (parameters.size() != 1 || !matrices.contains(parameters.front())) {
+        throw InvalidArgumentsError{};
+    }
+
+    return matrices.at(parameters.front());
+}
+
+// formats of the standard streams are given by extensions without the dot
+std::string ParseFormat(std::queue<std::string> parameters) {
+    if (parameters.size() != 1 || !image_io::IsFormatSupported("." + parameters.front())) {
+        throw InvalidArgumentsError{};
+    }
+
+    return "." + parameters.front();
+}
+
+// returns false if the alias is not an option, so the filters start with it
+bool ParseOption(const std::string& alias, const std::queue<std::string>& parameters, Pipeline& pipeline) {
+    if (alias == SCALE_OPTION || alias == FAST_SCALE_OPTION) {
+        pipeline.read_options.scale = ParseScale(parameters);
+        pipeline.read_options.scale_method = alias == SCALE_OPTION ? ScaleMethod::average : ScaleMethod::stride;
+    } else if (alias == DEPTH_OPTION) {
+        pipeline.write_options.depth = ParseDepth(parameters);
+    } else if (alias == SAMPLE_BITS_OPTION) {
+        pipeline.write_options.sample_bits = ParseSampleBits(parameters);
+    } else if (alias == TILE_SIZE_OPTION) {
+        pipeline.write_options.tile_size = ParseTileSize(parameters);
+    } else if (alias == FRAME_SIZE_OPTION) {
+        std::tie(pipeline.read_options.frame_width, pipeline.read_options.frame_height) = ParseFrameSize(parameters);
+    } else if (alias == MATRIX_OPTION) {
+        pipeline.read_options.matrix = ParseMatrix(parameters);
+    } else if (alias == INPUT_FORMAT_OPTION) {
+        pipeline.read_options.format = ParseFormat(parameters);
+    } else if (alias == OUTPUT_FORMAT_OPTION) {
+        pipeline.write_options.format = ParseFormat(parameters);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+void CheckInput(const std::string& input_path) {
+    if (!image_io::IsSupported(input_path)) {
+        throw UnsupportedFileFormat{input_path};
+    }
+    if (input_path != image_io::STANDARD_STREAM && !std::filesystem::exists(input_path)) {
+        throw FileNotFoundError{};
+    }
+}
+
+void CheckOutput(const std::string& output_path) {
+    if (!image_io::IsSupported(output_path)) {
+        throw UnsupportedFileFormat{output_path};
+    }
+}
+
+// options of the decoder, which is shared by all outputs
+bool IsReadOption(const std::string& alias) {
+    return alias == SCALE_OPTION || alias == FAST_SCALE_OPTION || alias == FRAME_SIZE_OPTION ||
+           alias == MATRIX_OPTION || alias == INPUT_FORMAT_OPTION;
+}
+
+// options and filters from argv[start, end), options go before the filters
+void ParseFilters(char** argv, size_t start, size_t end, bool read_options, Pipeline& pipeline) {
+    bool options = true;
+    std::optional<std::variant<RegionFilter::Parameters, MaskedFilter::Parameters>> scope;
+
+    while (start != end) {
+        std::string alias;
+        std::queue<std::string> parameters;
+        start = console_interface::ParseArguments(argv, start, end, alias, parameters);
+
+        if (!read_options && IsReadOption(alias)) {
+            throw InvalidArgumentsError{};
+        }
+        if (options && ParseOption(alias, parameters, pipeline)) {
+            continue;
+        }
+
+        options = false;
+
+        // -roi and -mask scope the filter after them
+        if (alias == RegionFilter::ALIAS || alias == MaskedFilter::ALIAS) {
+            if (scope.has_value()) {
+                throw InvalidArgumentsError{};
+            }
+
+            if (alias == RegionFilter::ALIAS) {
+                scope = RegionFilter::ParseParameters(std::move(parameters));
+            } else {
+                MaskedFilter::Parameters mask = MaskedFilter::ParseParameters(std::move(parameters));
+                if (mask.path == image_io::STANDARD_STREAM) {
+                    throw InvalidArgumentsError{};
+                }
+
+                CheckInput(mask.path);
+                scope = std::move(mask);
+            }
+            continue;
+        }
+
+        FilterNode filter = pipeline::ParseFilter(alias, std::move(parameters));
+        if (scope.has_value()) {
+            filter = std::visit([&filter](const auto& scoped) { return pipeline::Restrict(scoped, filter); }, *scope);
+            scope.reset();
+        }
+
+        pipeline.filters.push_back(std::move(filter));
+    }
+
+    if (scope.has_value()) {
+        throw InvalidArgumentsError{};
+    }
+}
+
+template <typename Filter>
+bool Is(const FilterNode& filter) {
+    return std::holds_alternative<Node<Filter>>(filter);
+}
+
+// filters which change every pixel independently of the others commute with crops
+bool IsPointFilter(const FilterNode& filter) {
+    return Is<GrayscaleFilter>(filter) || Is<NegativeFilter>(filter);
+}
+
+// filters which read neighbours of every pixel
+bool IsStencilFilter(const FilterNode& filter) {
+    return Is<SharpeningFilter>(filter) || Is<EdgeDetectionFilter>(filter) || Is<GaussianBlurFilter>(filter);
+}
+
+// the shortest text which is read back as the same number, so different parameters are never described the same
+std::string Number(double value) {
+    std::array<char, std::numeric_limits<double>::max_digits10 + 8> text{};
+    const auto end = std::to_chars(text.begin(), text.end(), value).ptr;
+    return {text.begin(), end};
+}
+
+// filters as they are written in the command line
+template <typename Iterator>
+std::string Describe(Iterator begin, Iterator end) {
+    std::ostringstream description;
+
+    for (auto filter = begin; filter != end; ++filter) {
+        std::visit(
+            [&description](const auto& node) {
+                using Filter = typename std::decay_t<decltype(node)>::Filter;
+
+                if constexpr (std::is_same_v<Filter, TiledFilter>) {
+                    description << "tiles of " << node.parameters.stages.size() << " filters";
+                } else if constexpr (std::is_same_v<Filter, PointFilter>) {
+                    const std::vector<PointFilter::Operation>& operations = node.parameters.operations;
+
+                    for (size_t i = 0; i != operations.size(); ++i) {
+                        description << (i == 0 ? "" : " ")
+                                    << (operations[i] == PointFilter::Operation::grayscale ? GrayscaleFilter::ALIAS
+                                                                                           : NegativeFilter::ALIAS);
+                    }
+                } else {
+                    description << Filter::ALIAS;
+                }
+
+                if constexpr (std::is_same_v<Filter, CropFilter>) {
+                    description << ' ' << node.parameters.width << ' ' << node.parameters.height;
+                } else if constexpr (std::is_same_v<Filter, RegionFilter>) {
+                    const Region& region = node.parameters.region;
+                    description << ' ' << region.left << ' ' << region.top << ' ' << region.width << ' '
+                                << region.height << ' ' << node.parameters.description;
+                } else if constexpr (std::is_same_v<Filter, MaskedFilter>) {
+                    description << ' ' << node.parameters.path << ' ' << node.parameters.description;
+                } else if constexpr (std::is_same_v<Filter, EdgeDetectionFilter>) {
+                    description << ' ' << Number(node.parameters.threshold);
+                } else if constexpr (std::is_same_v<Filter, GaussianBlurFilter>) {
+                    description << ' ' << Number(node.parameters.sigma);
+                }
+            },
+            *filter);
+
+        if (filter + 1 != end) {
+            description << ' ';
+        }
+    }
+
+    return begin == end ? "nothing" : description.str();
+}
+
+// rewrites filters i and i + 1 into a cheaper equivalent, returns false if no rule matches them
+bool Rewrite(std::vector<FilterNode>& filters, size_t i, std::vector<std::string>& rewrites) {
+    const FilterNode& first = filters[i];
+    const FilterNode& second = filters[i + 1];
+    const std::string before = Describe(filters.begin() + i, filters.begin() + i + 2);
+
+    size_t size = 1;  // filters the pair is rewritten into
+
+    if (Is<NegativeFilter>(first) && Is<NegativeFilter>(second)) {
+        filters.erase(filters.begin() + i, filters.begin() + i + 2);
+        size = 0;
+    } else if (Is<GrayscaleFilter>(first) && Is<GrayscaleFilter>(second)) {
+        filters.erase(filters.begin() + i + 1);
+    } else if (Is<CropFilter>(first) && Is<CropFilter>(second)) {
+        // crops keep the top left corner, so the second one only narrows the first
+        auto [width, height] = std::get<Node<CropFilter>>(first).parameters;
+        auto [next_width, next_height] = std::get<Node<CropFilter>>(second).parameters;
+        filters[i] = Node<CropFilter>{{std::min(width, next_width), std::min(height, next_height)}};
+        filters.erase(filters.begin() + i + 1);
+    } else if (IsPointFilter(first) && Is<CropFilter>(second)) {
+        // point filters are applied to fewer pixels after the crop
+        std::swap(filters[i], filters[i + 1]);
+        size = 2;
+    } else {
+        return false;
+    }
+
+    rewrites.push_back(before + " -> " + Describe(filters.begin() + i, filters.begin() + i + size));
+    return true;
+}
+
+// runs of point filters after the first skipped ones are replaced by single passes
+void FusePointFilters(std::vector<FilterNode>& filters, size_t skipped) {
+    std::vector<FilterNode> fused(filters.begin(), filters.begin() + static_cast<int64_t>(skipped));
+
+    for (size_t i = skipped; i != filters.size();) {
+        size_t end = i;
+        while (end != filters.size() && IsPointFilter(filters[end])) {
+            ++end;
+        }
+
+        if (end - i < 2) {
+            fused.push_back(filters[i++]);
+            continue;
+        }
+
+        PointFilter::Parameters parameters;
+        for (; i != end; ++i) {
+            parameters.operations.push_back(Is<GrayscaleFilter>(filters[i]) ? PointFilter::Operation::grayscale
+                                                                             : PointFilter::Operation::negative);
+        }
+
+        fused.push_back(Node<PointFilter>{parameters});
+    }
+
+    filters = std::move(fused);
+}
+
+// runs of two or more stencil and point filters after the first skipped ones are replaced by tiled passes
+void FuseStencilFilters(std::vector<FilterNode>& filters, size_t skipped) {
+    std::vector<FilterNode> fused(filters.begin(), filters.begin() + static_cast<int64_t>(skipped));
+
+    for (size_t i = skipped; i != filters.size();) {
+        size_t end = i;
+        bool stencil = false;
+
+        while (end != filters.size() && (IsStencilFilter(filters[end]) || IsPointFilter(filters[end]) ||
+                                         Is<PointFilter>(filters[end]))) {
+            stencil = stencil || IsStencilFilter(filters[end]);
+            ++end;
+        }
+
+        if (end - i < 2 || !stencil) {
+            fused.insert(fused.end(), filters.begin() + static_cast<int64_t>(i),
+                         filters.begin() + static_cast<int64_t>(std::max(end, i + 1)));
+            i = std::max(end, i + 1);
+            continue;
+        }
+
+        TiledFilter::Parameters parameters{{}, 0};
+        for (; i != end; ++i) {
+            parameters.stages.emplace_back([filter = filters[i]](Image& img) { pipeline::Apply(filter, img); });
+            parameters.halo += pipeline::Radius(filters[i]);
+        }
+
+        fused.push_back(Node<TiledFilter>{parameters});
+    }
+
+    filters = std::move(fused);
+}
+}  // namespace
+
+Pipeline pipeline::Parse(int argc, char** argv) {
+    if (argc < 3) {
+        throw InvalidArgumentsError{};
+    }
+
+    Pipeline pipeline;
+    pipeline.input_path = argv[1];
+    pipeline.output_path = argv[2];
+    CheckInput(pipeline.input_path);
+    CheckOutput(pipeline.output_path);
+    ParseFilters(argv, 3, argc, true, pipeline);
+
+    std::vector<FilterNode>& filters = pipeline.filters;
+    pipeline.rewrites = Optimize(filters);
+    pipeline.description = Describe(filters.begin(), filters.end());
+
+    // a leading crop is passed to the decoder, so only the needed part of the file is read
+    if (!filters.empty() && Is<CropFilter>(filters.front())) {
+        auto [width, height] = std::get<Node<CropFilter>>(filters.front()).parameters;
+        pipeline.read_options.window = Region{0, 0, height, width};
+        filters.erase(filters.begin());
+    }
+
+    // a leading grayscale filter needs only brightness, so readers of raw frames skip chroma
+    pipeline.read_options.luma_only = !filters.empty() && Is<GrayscaleFilter>(filters.front());
+
+    FusePointFilters(filters, pipeline.read_options.luma_only ? 1 : 0);
+    FuseStencilFilters(filters, pipeline.read_options.luma_only ? 1 : 0);
+
+    return pipeline;
+}
+
+std::vector<Pipeline> pipeline::ParseOutputs(int argc, char** argv) {
+    std::vector<size_t> outputs;  // positions of -o
+    for (size_t i = 2; i < static_cast<size_t>(argc); ++i) {
+        if (argv[i] == OUTPUT_OPTION) {
+            outputs.push_back(i);
+        }
+    }
+
+    if (outputs.empty()) {
+        return {Parse(argc, argv)};
+    }
+
+    // options before the first output are common, the decoder options can be given only there
+    Pipeline common;
+    common.input_path = argv[1];
+    CheckInput(common.input_path);
+    ParseFilters(argv, 2, outputs.front(), true, common);
+
+    if (!common.filters.empty()) {
+        throw InvalidArgumentsError{};
+    }
+
+    outputs.push_back(argc);
+    std::vector<Pipeline> pipelines;
+    size_t standard_outputs = 0;
+
+    for (size_t i = 0; i + 1 != outputs.size(); ++i) {
+        // the path goes right after -o, so it can be - for the standard output
+        if (outputs[i] + 1 == outputs[i + 1]) {
+            throw InvalidArgumentsError{};
+        }
+
+        Pipeline& pipeline = pipelines.emplace_back(common);
+        pipeline.output_path = argv[outputs[i] + 1];
+        CheckOutput(pipeline.output_path);
+        ParseFilters(argv, outputs[i] + 2, outputs[i + 1], false, pipeline);
+
+        pipeline.rewrites = Optimize(pipeline.filters);
+        pipeline.description = Describe(pipeline.filters.begin(), pipeline.filters.end());
+        FusePointFilters(pipeline.filters, 0);
+        FuseStencilFilters(pipeline.filters, 0);
+
+        standard_outputs += pipeline.output_path == image_io::STANDARD_STREAM ? 1 : 0;
+    }
+
+    if (standard_outputs > 1) {
+        throw InvalidArgumentsError{};
+    }
+
+    // if every output starts with a crop, only the part of the file covering all of them is decoded
+    const bool cropped = std::all_of(pipelines.begin(), pipelines.end(), [](const Pipeline& pipeline) {
+        return !pipeline.filters.empty() && Is<CropFilter>(pipeline.filters.front());
+    });
+
+    if (cropped) {
+        Region window{0, 0, 0, 0};
+        for (const Pipeline& pipeline : pipelines) {
+            auto [width, height] = std::get<Node<CropFilter>>(pipeline.filters.front()).parameters;
+            window.height = std::max(window.height, height);
+            window.width = std::max(window.width, width);
+        }
+
+        for (Pipeline& pipeline : pipelines) {
+            pipeline.read_options.window = window;
+        }
+    }
+
+    return pipelines;
+}
+
+FilterNode pipeline::ParseFilter(const std::string& alias, std::queue<std::string> parameters) {
+    const auto parser = FILTER_PARSERS.find(alias);
+    if (parser == FILTER_PARSERS.end()) {
+        throw InvalidArgumentsError{};
+    }
+
+    try {
+        return parser->second(std::move(parameters));
+    } catch (const std::out_of_range& e) {
+        throw InvalidArgumentsError{};
+    }
+}
+
+FilterNode pipeline::Restrict(RegionFilter::Parameters region, const FilterNode& filter) {
+    if (Is<CropFilter>(filter) || Is<RegionFilter>(filter) || Is<MaskedFilter>(filter)) {
+        throw InvalidArgumentsError{};
+    }
+
+    region.filter = [filter](Image& img) { pipeline::Apply(filter, img); };
+    region.halo = Radius(filter);
+    region.description = Describe(&filter, &filter + 1);
+
+    return Node<RegionFilter>{region};
+}
+
+FilterNode pipeline::Restrict(MaskedFilter::Parameters mask, const FilterNode& filter) {
+    if (Is<CropFilter>(filter) || Is<RegionFilter>(filter) || Is<MaskedFilter>(filter)) {
+        throw InvalidArgumentsError{};
+    }
+
+    mask.filter = [filter](Image& img) { pipeline::Apply(filter, img); };
+    mask.halo = Radius(filter);
+    mask.description = Describe(&filter, &filter + 1);
+
+    return Node<MaskedFilter>{std::move(mask)};
+}
+
+std::vector<std::string> pipeline::Optimize(std::vector<FilterNode>& filters) {
+    std::vector<std::string> rewrites;
+
+    // rules are applied to adjacent filters until none of them matches
+    for (size_t i = 0; i + 1 < filters.size();) {
+        if (Rewrite(filters, i, rewrites)) {
+            i = i == 0 ? 0 : i - 1;
+        } else {
+            ++i;
+        }
+    }
+
+    return rewrites;
+}
+
+int64_t pipeline::Radius(const FilterNode& filter) {
+    return std::visit(
+        [](const auto& node) -> int64_t {
+            using Filter = typename std::decay_t<decltype(node)>::Filter;
+
+            if constexpr (std::is_same_v<Filter, SharpeningFilter> || std::is_same_v<Filter, EdgeDetectionFilter> ||
+                          std::is_same_v<Filter, GaussianBlurFilter>) {
+                return Filter::Radius(node.parameters);
+            } else if constexpr (std::is_same_v<Filter, TiledFilter> || std::is_same_v<Filter, RegionFilter> ||
+                                 std::is_same_v<Filter, MaskedFilter>) {
+                return node.parameters.halo;
+            } else {
+                return 0;
+            }
+        },
+        filter);
+}
+
+void pipeline::Apply(const FilterNode& filter, Image& img) {
+    std::visit(
+        [&img](const auto& node) {
+            using Filter = typename std::decay_t<decltype(node)>::Filter;
+
+            // the mask of the command line is read after the input, when the filter is applied
+            if constexpr (std::is_same_v<Filter, MaskedFilter>) {
+                if (node.parameters.mask == nullptr) {
+                    MaskedFilter::Parameters parameters = node.parameters;
+                    Image* mask = nullptr;
+                    parameters.mask.reset(image_io::ReadFile(parameters.path, mask));
+                    Filter().Apply(img, parameters);
+                    return;
+                }
+            }
+
+            Filter().Apply(img, node.parameters);
+        },
+        filter);
+}
@@ -0,0 +1,218 @@
+#include "../utils/pnm_reader.h"
+
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <sstream>
+
+namespace {
+const uint8_t BYTE = 8;
+const uint32_t MAX_8_BITS_SAMPLE = UINT8_MAX;
+const uint32_t MAX_SAMPLE = UINT16_MAX;
+
+struct Header {
+    char type;
+    int64_t width;
+    int64_t height;
+    int64_t depth;  // samples per pixel
+    uint32_t max_value;
+};
+
+// skips whitespaces and comments between the tokens of P5 and P6 headers
+void SkipSpaces(std::istream& f) {
+    while (f) {
+        const int symbol = f.peek();
+
+        if (symbol == '#') {
+            f.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        } else if (std::isspace(symbol)) {
+            f.get();
+        } else {
+            return;
+        }
+    }
+}
+
+int64_t ReadNumber(std::istream& f) {
+    SkipSpaces(f);
+
+    int64_t number = -1;
+    f >> number;
+
+    return number;
+}
+
+Header ParseHeader(std::istream& f, const std::string& file_path) {
+    Header header{};
+    char magic[2];
+    f.read(magic, 2);
+
+    if (!f || magic[0] != 'P' || (magic[1] != '5' && magic[1] != '6' && magic[1] != '7')) {
+        throw UnsupportedFileFormat{file_path};
+    }
+
+    header.type = magic[1];
+
+    if (header.type != '7') {
+        header.width = ReadNumber(f);
+        header.height = ReadNumber(f);
+        header.max_value = ReadNumber(f);
+        header.depth = header.type == '5' ? 1 : 3;
+        f.get();  // single whitespace before the raster
+    } else {
+        std::string line;
+
+        while (std::getline(f, line) && line != "ENDHDR") {
+            std::istringstream fields(line);
+            std::string name;
+            fields >> name;
+
+            if (name == "WIDTH") {
+                fields >> header.width;
+            } else if (name == "HEIGHT") {
+                fields >> header.height;
+            } else if (name == "DEPTH") {
+                fields >> header.depth;
+            } else if (name == "MAXVAL") {
+                fields >> header.max_value;
+            }
+        }
+    }
+
+    if (!f || header.width <= 0 || header.height <= 0 || header.depth < 1 || header.depth > 4 ||
+        header.max_value == 0 || header.max_value > MAX_SAMPLE) {
+        throw UnsupportedFileFormat{"Wrong Netpbm header"};
+    }
+
+    const int64_t sample_size = header.max_value > MAX_8_BITS_SAMPLE ? 2 : 1;
+    CheckRemainingBytes(f, CheckRasterSize(header.height, header.width, header.depth * sample_size, "Netpbm"));
+
+    return header;
+}
+}  // namespace
+
+namespace {
+Image* Decode(std::istream& f, Image* img, const ReadOptions& options, const std::string& name) {
+    const Header header = ParseHeader(f, name);
+    const std::streamoff raster_offset = f.tellg();
+
+    ImageBuilder builder(header.height, header.width, 0, 0, options);
+    const Region& source = builder.Source();
+
+    // rows have no padding, so every needed part of a row is one contiguous read
+    const int64_t sample_size = header.max_value > MAX_8_BITS_SAMPLE ? 2 : 1;
+    const int64_t pixel_size = header.depth * sample_size;
+    std::vector<uint8_t> row(source.width * pixel_size);
+    std::vector<uint16_t> rgb(3 * source.width);
+
+    // gray samples are repeated in all channels, alpha is dropped
+    const int64_t channels = header.depth > 2 ? 3 : 1;
+
+    for (int64_t y = source.top; y != source.top + source.height; ++y) {
+        if (!builder.IsRowNeeded(y)) {
+            continue;
+        }
+
+        f.seekg(raster_offset + (y * header.width + source.left) * pixel_size);
+        f.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row.size()));
+
+        if (!f) {
+            throw UnsupportedFileFormat{"Truncated raster"};
+        }
+
+        for (int64_t x = 0; x != source.width; ++x) {
+            for (int64_t c = 0; c != 3; ++c) {
+                const uint8_t* sample = &row[x * pixel_size + (channels == 1 ? 0 : c) * sample_size];
+                rgb[3 * x + c] = sample_size == 1 ? sample[0] : (sample[0] << BYTE) | sample[1];
+            }
+        }
+
+        builder.AddRow(y, rgb.data(), header.max_value);
+    }
+
+    ColorMode color_mode = ColorMode::rgb;
+    if (channels == 1) {
+        color_mode = header.max_value == 1 ? ColorMode::monochrome : ColorMode::grayscale;
+    }
+
+    img = builder.Release(color_mode);
+
+    return img;
+}
+}  // namespace
+
+Image* pnm_reader::ReadFile(const std::string& file_path, Image* img, const ReadOptions& options) {
+    std::ifstream f;
+    f.open(file_path, std::ios::in | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileNotFoundError{};
+    }
+
+    return Decode(f, img, options, file_path);
+}
+
+Image* pnm_reader::ReadStream(std::istream& f, Image* img, const ReadOptions& options) {
+    return Decode(f, img, options, "Input stream");
+}
+
+void pnm_reader::SaveFile(const std::string& output_path, Image* img, const WriteOptions& options) {
+    std::fstream f;
+    f.open(output_path, std::ios::out | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileCreationError{};
+    }
+
+    SaveStream(f, img, options, std::filesystem::path(output_path).extension().string());
+    f.close();
+}
+
+void pnm_reader::SaveStream(std::ostream& f, Image* img, const WriteOptions& options, const std::string& extension) {
+    auto [height, width] = img->Shape();
+
+    ColorDepth depth = options.depth;
+    if (depth == ColorDepth::automatic) {
+        depth = DetectColorDepth(*img);
+    }
+    if (extension == ".pgm") {
+        depth = ColorDepth::grayscale;
+    } else if (extension == ".ppm") {
+        depth = ColorDepth::rgb;
+    }
+
+    const int64_t channels = depth == ColorDepth::rgb ? 3 : 1;
+    const uint32_t max_value = options.sample_bits == 2 * BYTE ? MAX_SAMPLE : MAX_8_BITS_SAMPLE;
+    const int64_t sample_size = max_value > MAX_8_BITS_SAMPLE ? 2 : 1;
+
+    if (extension == ".pam") {
+        f << "P7\nWIDTH " << width << "\nHEIGHT " << height << "\nDEPTH " << channels << "\nMAXVAL " << max_value
+          << "\nTUPLTYPE " << (channels == 3 ? "RGB" : "GRAYSCALE") << "\nENDHDR\n";
+    } else {
+        f << "P" << (channels == 3 ? '6' : '5') << "\n" << width << " " << height << "\n" << max_value << "\n";
+    }
+
+    std::vector<uint8_t> row(width * channels * sample_size);
+    for (const auto& pixels : img->GetPixels()) {
+        uint8_t* sample = row.data();
+
+        for (const Pixel& pixel : pixels) {
+            const double colors[] = {pixel.r, pixel.g, pixel.b};
+
+            for (int64_t c = 0; c != channels; ++c) {
+                const double color = channels == 1 ? GrayLevel(pixel) : colors[c];
+
+                if (sample_size == 1) {
+                    *sample++ = static_cast<uint8_t>(color * MAX_8_BITS_SAMPLE);
+                } else {
+                    const auto value = static_cast<uint16_t>(std::lround(color * MAX_SAMPLE));
+                    *sample++ = value >> BYTE;
+                    *sample++ = value & MAX_8_BITS_SAMPLE;
+                }
+            }
+        }
+
+        f.write(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+}
@@ -1,15 +1,90 @@
 #include "../utils/processor.h"
 #include "../utils/console_interface.h"
+#include "../utils/parallel.h"
+
+#include <filesystem>
+#include <optional>
+#include <tuple>
 
 namespace {
-const std::map<std::string, AbstractFilter*> FILTERS_ALIASES{{CropFilter::ALIAS, new CropFilter()},
-                                                             {GrayscaleFilter::ALIAS, new GrayscaleFilter()},
-                                                             {NegativeFilter::ALIAS, new NegativeFilter()},
-                                                             {SharpeningFilter::ALIAS, new SharpeningFilter()},
-                                                             {EdgeDetectionFilter::ALIAS, new EdgeDetectionFilter()},
-                                                             {GaussianBlurFilter::ALIAS, new GaussianBlurFilter()}};
+const std::string PROBE_OPTION = "--probe";
+const std::string GRAPH_OPTION = "--graph";
+const std::string CACHE_OPTION = "--cache";
+
+// the input is decoded once and shared by the outputs, which are computed in parallel
+void RunOutputs(const std::vector<Pipeline>& plans) {
+    Image* img = nullptr;
+    const std::shared_ptr<const Image> input(
+        image_io::ReadFile(plans.front().input_path, img, plans.front().read_options));
+
+    ParallelFor(static_cast<int64_t>(plans.size()), [&plans, &input](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i != end; ++i) {
+            LazyImage output = LazyImage::FromImage(input);
+
+            for (const FilterNode& filter : plans[i].filters) {
+                output = output.Apply(filter);
+            }
+
+            output.SaveFile(plans[i].output_path, plans[i].write_options);
+        }
+    });
+}
+
+void Run(const std::vector<Pipeline>& plans) {
+    if (plans.size() != 1) {
+        RunOutputs(plans);
+        return;
+    }
+
+    const Pipeline& plan = plans.front();
+    const std::vector<FilterNode>& filters = plan.filters;
+
+    // only the part of the image the result depends on is read and filtered
+    LazyImage img = LazyImage::Read(plan.input_path, plan.read_options);
+
+    for (const FilterNode& filter : filters) {
+        img = img.Apply(filter);
+    }
+
+    img.SaveFile(plan.output_path, plan.write_options);
+}
+
+// stored outputs are copied, the others are computed into temporary files of the cache and stored
+void RunCached(const std::vector<Pipeline>& plans, ResultCache& cache) {
+    std::vector<Pipeline> missing;
+    std::vector<std::tuple<std::string, std::string, const Pipeline*>> stored;  // key, temporary path, job
+
+    for (const Pipeline& plan : plans) {
+        const std::optional<std::string> key = cache.Key(plan);
+
+        if (!key.has_value()) {
+            missing.push_back(plan);
+        } else if (!cache.Fetch(*key, plan)) {
+            const std::string temporary_path = cache.TemporaryPath(plan);
+            stored.emplace_back(*key, temporary_path, &plan);
+            missing.push_back(plan);
+            missing.back().output_path = temporary_path;
+        }
+    }
+
+    if (missing.empty()) {
+        return;
+    }
 
+    try {
+        Run(missing);
+    } catch (...) {
+        for (const auto& [key, temporary_path, plan] : stored) {
+            std::filesystem::remove(temporary_path);
+        }
+        throw;
+    }
+
+    for (const auto& [key, temporary_path, plan] : stored) {
+        cache.Store(key, temporary_path, *plan);
+    }
 }
+}  // namespace
 
 void ImageProcessor(int argc, char** argv) {
     if (argc == 1 || argc == 2) {
@@ -17,38 +92,47 @@ void ImageProcessor(int argc, char** argv) {
         return;
     }
 
-    std::string input_path = argv[1];
-    std::string output_path = argv[2];
+    if (argv[1] == PROBE_OPTION) {
+        if (argc != 3) {
+            throw InvalidArgumentsError{};
+        }
 
-    if (!input_path.ends_with(".bmp") || !output_path.ends_with(".bmp")) {
-        throw UnsupportedFileFormat{"Not .bmp"};
+        console_interface::PrintHeader(bmp_reader::ReadHeader(argv[2]));
+        return;
     }
 
-    Image* img = nullptr;
-    img = bmp_reader::ReadFile(input_path, img);
-
-    size_t start = 3;
+    if (argv[1] == GRAPH_OPTION) {
+        if (argc != 3) {
+            throw InvalidArgumentsError{};
+        }
 
-    while (start != static_cast<size_t>(argc)) {
-        std::string filter_alias;
-        std::queue<std::string> parameters;
-        start = console_interface::ParseArguments(argv, start, argc, filter_alias, parameters);
+        graph::Run(graph::ParseFile(argv[2]));
+        return;
+    }
 
-        try {
-            FILTERS_ALIASES.at(filter_alias)->Apply(*img, parameters);
-        } catch (const std::out_of_range& e) {
+    // the rest of the command line is a usual job, argv[0] is not used by the parser
+    std::optional<ResultCache> cache;
+    if (argv[1] == CACHE_OPTION) {
+        if (argc < 5) {
             throw InvalidArgumentsError{};
         }
 
-        filter_alias.clear();
-        console_interface::Clear(parameters);
+        cache.emplace(argv[2]);
+        argc -= 2;
+        argv += 2;
     }
 
-    bmp_reader::SaveFile(output_path, img);
+    const std::vector<Pipeline> plans = pipeline::ParseOutputs(argc, argv);
 
-    for (auto [key, val] : FILTERS_ALIASES) {
-        delete val;
+    for (const Pipeline& plan : plans) {
+        for (const std::string& rewrite : plan.rewrites) {
+            std::cerr << "rewrite: " << rewrite << std::endl;
+        }
     }
 
-    delete img;
+    if (cache.has_value()) {
+        RunCached(plans, *cache);
+    } else {
+        Run(plans);
+    }
 }
\ No newline at end of file
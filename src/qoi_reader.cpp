@@ -0,0 +1,232 @@
+#include "../utils/qoi_reader.h"
+
+#include <array>
+
+namespace {
+const uint8_t HEADER_SIZE = 14;
+const uint8_t INDEX_SIZE = 64;
+const uint8_t MAX_RUN = 62;
+const uint8_t CHANNELS = 3;
+const size_t WRITE_BUFFER_SIZE = 1 << 16;
+
+const uint8_t OP_INDEX = 0x00;
+const uint8_t OP_DIFF = 0x40;
+const uint8_t OP_LUMA = 0x80;
+const uint8_t OP_RUN = 0xc0;
+const uint8_t OP_RGB = 0xfe;
+const uint8_t OP_RGBA = 0xff;
+const uint8_t OP_MASK = 0xc0;
+
+const std::array<uint8_t, 8> END_MARKER = {0, 0, 0, 0, 0, 0, 0, 1};
+
+using Color = std::array<uint8_t, 4>;
+
+uint8_t Hash(const Color& color) {
+    return (color[0] * 3 + color[1] * 5 + color[2] * 7 + color[3] * 11) % INDEX_SIZE;  // NOLINT
+}
+
+uint32_t BigEndianRead(const uint8_t* array) {
+    return (array[0] << 24) | (array[1] << 16) | (array[2] << 8) | array[3];  // NOLINT
+}
+
+void BigEndianWrite(uint8_t* array, uint32_t data) {
+    for (size_t i = 0; i != 4; ++i) {
+        array[i] = data >> (8 * (3 - i));  // NOLINT
+    }
+}
+
+class Decoder {
+private:
+    std::streambuf* input_;
+    std::array<Color, INDEX_SIZE> index_{};
+    Color color_ = {0, 0, 0, UINT8_MAX};
+    uint8_t run_ = 0;
+
+    uint8_t NextByte() {
+        auto byte = input_->sbumpc();
+
+        if (byte == std::streambuf::traits_type::eof()) {
+            throw UnsupportedFileFormat{"Truncated QOI stream"};
+        }
+
+        return static_cast<uint8_t>(byte);
+    }
+
+public:
+    explicit Decoder(std::streambuf* input) : input_(input) {
+    }
+
+    const Color& NextPixel() {
+        if (run_ != 0) {
+            --run_;
+            return color_;
+        }
+
+        const uint8_t tag = NextByte();
+
+        if (tag == OP_RGB || tag == OP_RGBA) {
+            for (size_t i = 0; i != (tag == OP_RGB ? 3 : 4); ++i) {
+                color_[i] = NextByte();
+            }
+        } else if ((tag & OP_MASK) == OP_INDEX) {
+            color_ = index_[tag];
+        } else if ((tag & OP_MASK) == OP_DIFF) {
+            color_[0] += ((tag >> 4) & 0x03) - 2;  // NOLINT
+            color_[1] += ((tag >> 2) & 0x03) - 2;  // NOLINT
+            color_[2] += (tag & 0x03) - 2;         // NOLINT
+        } else if ((tag & OP_MASK) == OP_LUMA) {
+            const uint8_t next = NextByte();
+            const int green_difference = (tag & 0x3f) - 32;            // NOLINT
+            color_[0] += green_difference - 8 + ((next >> 4) & 0x0f);  // NOLINT
+            color_[1] += green_difference;
+            color_[2] += green_difference - 8 + (next & 0x0f);  // NOLINT
+        } else {
+            run_ = tag & 0x3f;  // NOLINT
+        }
+
+        index_[Hash(color_)] = color_;
+        return color_;
+    }
+};
+}  // namespace
+
+namespace {
+Image* Decode(std::istream& f, Image* img, const ReadOptions& options, const std::string& name) {
+    uint8_t header[HEADER_SIZE];
+    f.read(reinterpret_cast<char*>(header), HEADER_SIZE);
+
+    if (!f || header[0] != 'q' || header[1] != 'o' || header[2] != 'i' || header[3] != 'f') {
+        throw UnsupportedFileFormat{name};
+    }
+
+    const int64_t width = BigEndianRead(header + 4);
+    const int64_t height = BigEndianRead(header + 8);  // NOLINT
+    CheckRasterSize(height, width, CHANNELS, "QOI");
+
+    ImageBuilder builder(height, width, 0, 0, options);
+    const Region& source = builder.Source();
+    std::vector<uint8_t> rgb(CHANNELS * source.width);
+    Decoder decoder(f.rdbuf());
+
+    // pixels are one stream, so everything before the window is decoded and the rest is never read
+    for (int64_t y = 0; y != source.top + source.height; ++y) {
+        const bool needed = builder.IsRowNeeded(y);
+
+        for (int64_t x = 0; x != width; ++x) {
+            const Color& color = decoder.NextPixel();
+
+            if (needed && x >= source.left && x < source.left + source.width) {
+                std::copy(color.begin(), color.begin() + CHANNELS, rgb.begin() + CHANNELS * (x - source.left));
+            }
+        }
+
+        builder.AddRow(y, rgb.data(), UINT8_MAX);
+    }
+
+    return builder.Release();
+}
+}  // namespace
+
+Image* qoi_reader::ReadFile(const std::string& file_path, Image* img, const ReadOptions& options) {
+    std::ifstream f;
+    f.open(file_path, std::ios::in | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileNotFoundError{};
+    }
+
+    return Decode(f, img, options, file_path);
+}
+
+Image* qoi_reader::ReadStream(std::istream& f, Image* img, const ReadOptions& options) {
+    return Decode(f, img, options, "Input stream");
+}
+
+void qoi_reader::SaveFile(const std::string& output_path, Image* img, const WriteOptions& options) {
+    std::fstream f;
+    f.open(output_path, std::ios::out | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileCreationError{};
+    }
+
+    SaveStream(f, img, options);
+    f.close();
+}
+
+void qoi_reader::SaveStream(std::ostream& f, Image* img, const WriteOptions& options) {
+    auto [height, width] = img->Shape();
+
+    uint8_t header[HEADER_SIZE] = {'q', 'o', 'i', 'f'};
+    BigEndianWrite(header + 4, width);
+    BigEndianWrite(header + 8, height);  // NOLINT
+    header[12] = CHANNELS;               // NOLINT
+    header[13] = 0;                      // NOLINT sRGB with linear alpha
+    f.write(reinterpret_cast<char*>(header), HEADER_SIZE);
+
+    std::array<Color, INDEX_SIZE> index{};
+    Color previous = {0, 0, 0, UINT8_MAX};
+    uint8_t run = 0;
+
+    std::vector<uint8_t> buffer;
+    buffer.reserve(WRITE_BUFFER_SIZE + 4);
+
+    for (const auto& row : img->GetPixels()) {
+        for (const Pixel& pixel : row) {
+            auto [r, g, b] = pixel.ToRGB();
+            const Color color = {r, g, b, UINT8_MAX};
+
+            if (color == previous) {
+                if (++run == MAX_RUN) {
+                    buffer.push_back(OP_RUN | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run != 0) {
+                buffer.push_back(OP_RUN | (run - 1));
+                run = 0;
+            }
+
+            const uint8_t hash = Hash(color);
+            if (index[hash] == color) {
+                buffer.push_back(OP_INDEX | hash);
+            } else {
+                index[hash] = color;
+
+                const auto red_difference = static_cast<int8_t>(color[0] - previous[0]);
+                const auto green_difference = static_cast<int8_t>(color[1] - previous[1]);
+                const auto blue_difference = static_cast<int8_t>(color[2] - previous[2]);
+                const int red_green = red_difference - green_difference;
+                const int blue_green = blue_difference - green_difference;
+
+                if (red_difference >= -2 && red_difference <= 1 && green_difference >= -2 && green_difference <= 1 &&
+                    blue_difference >= -2 && blue_difference <= 1) {
+                    buffer.push_back(OP_DIFF | ((red_difference + 2) << 4) | ((green_difference + 2) << 2) |  // NOLINT
+                                     (blue_difference + 2));
+                } else if (green_difference >= -32 && green_difference <= 31 && red_green >= -8 &&  // NOLINT
+                           red_green <= 7 && blue_green >= -8 && blue_green <= 7) {                 // NOLINT
+                    buffer.push_back(OP_LUMA | (green_difference + 32));                            // NOLINT
+                    buffer.push_back(((red_green + 8) << 4) | (blue_green + 8));                    // NOLINT
+                } else {
+                    buffer.insert(buffer.end(), {OP_RGB, color[0], color[1], color[2]});
+                }
+            }
+
+            previous = color;
+
+            if (buffer.size() >= WRITE_BUFFER_SIZE) {
+                f.write(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+    }
+
+    if (run != 0) {
+        buffer.push_back(OP_RUN | (run - 1));
+    }
+
+    buffer.insert(buffer.end(), END_MARKER.begin(), END_MARKER.end());
+    f.write(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+}
@@ -0,0 +1,191 @@
+#include "../utils/recompute_cache.h"
+#include "../utils/image_io.h"
+
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <sstream>
+
+namespace {
+const std::string RESPONSE_KEY = "laplacian";
+
+// the file with its modification time and size, so changed files are read again
+std::string SourceKey(const std::string& file_path, const ReadOptions& options) {
+    if (!std::filesystem::exists(file_path)) {
+        throw FileNotFoundError{};
+    }
+
+    std::ostringstream key;
+    key << std::filesystem::absolute(file_path).string() << '\n'
+        << std::filesystem::last_write_time(file_path).time_since_epoch().count() << ' '
+        << std::filesystem::file_size(file_path) << ' ' << options.scale << ' '
+        << static_cast<int>(options.scale_method) << ' ' << options.frame_width << ' ' << options.frame_height << ' '
+        << static_cast<int>(options.matrix) << ' ' << options.luma_only << ' ' << options.format;
+
+    if (options.window.has_value()) {
+        const Region& window = *options.window;
+        key << ' ' << window.top << ' ' << window.left << ' ' << window.height << ' ' << window.width;
+    }
+
+    return key.str();
+}
+
+// the filter as in the command line, empty for the filters whose results are not stored
+std::optional<std::string> FilterKey(const FilterNode& filter) {
+    std::ostringstream key;
+    key.precision(std::numeric_limits<double>::max_digits10);
+
+    std::visit(
+        [&key](const auto& node) {
+            using Filter = typename std::decay_t<decltype(node)>::Filter;
+
+            if constexpr (std::is_same_v<Filter, CropFilter>) {
+                key << Filter::ALIAS << ' ' << node.parameters.width << ' ' << node.parameters.height;
+            } else if constexpr (std::is_same_v<Filter, GrayscaleFilter> || std::is_same_v<Filter, NegativeFilter> ||
+                                 std::is_same_v<Filter, SharpeningFilter>) {
+                key << Filter::ALIAS;
+            } else if constexpr (std::is_same_v<Filter, EdgeDetectionFilter>) {
+                key << Filter::ALIAS << ' ' << node.parameters.threshold;
+            } else if constexpr (std::is_same_v<Filter, GaussianBlurFilter>) {
+                key << Filter::ALIAS << ' ' << node.parameters.sigma;
+            }
+        },
+        filter);
+
+    std::string text = key.str();
+    return text.empty() ? std::nullopt : std::optional<std::string>(std::move(text));
+}
+
+size_t ImageBytes(const Image& img) {
+    auto [height, width] = img.Shape();
+    return height * width * sizeof(Pixel);
+}
+}  // namespace
+
+const size_t RecomputeCache::DEFAULT_CAPACITY = 1ul << 30;
+
+RecomputeCache::RecomputeCache(size_t capacity) : capacity_(capacity) {
+}
+
+template <typename Value>
+const Value* RecomputeCache::Find(const std::string& key) {
+    const auto entry = entries_.find(key);
+
+    if (entry == entries_.end()) {
+        return nullptr;
+    }
+
+    recent_.splice(recent_.begin(), recent_, entry->second.position);
+    return &std::get<Value>(entry->second.value);
+}
+
+template <typename Value>
+void RecomputeCache::Store(const std::string& key, Value value, size_t bytes) {
+    if (bytes > capacity_ || entries_.contains(key)) {
+        return;
+    }
+
+    recent_.push_front(key);
+    entries_.emplace(key, Entry{std::move(value), bytes, recent_.begin()});
+    size_ += bytes;
+
+    while (size_ > capacity_) {
+        const auto oldest = entries_.find(recent_.back());
+        size_ -= oldest->second.bytes;
+        entries_.erase(oldest);
+        recent_.pop_back();
+    }
+}
+
+Image* RecomputeCache::Run(const std::string& input_path, const ReadOptions& read_options,
+                           const std::vector<FilterNode>& filters) {
+    // keys[i] is the key of the result of the first i filters
+    std::vector<std::string> keys;
+
+    if (input_path != image_io::STANDARD_STREAM) {
+        keys.push_back(SourceKey(input_path, read_options));
+
+        for (const FilterNode& filter : filters) {
+            const std::optional<std::string> key = FilterKey(filter);
+            if (!key.has_value()) {
+                break;
+            }
+
+            keys.push_back(keys.back() + ' ' + *key);
+        }
+    }
+
+    // the run starts from the longest stored prefix
+    size_t start = keys.size();
+    const Image* cached = nullptr;
+
+    while (start != 0 && cached == nullptr) {
+        cached = Find<Image>(keys[--start]);
+    }
+
+    // the cached image is copied only when a filter has to change it, before anything else is stored
+    std::unique_ptr<Image> img;
+    auto materialize = [&]() -> Image& {
+        if (img == nullptr) {
+            Image* source = nullptr;
+            img.reset(cached != nullptr ? new Image(*cached) : image_io::ReadFile(input_path, source, read_options));
+
+            if (cached == nullptr && !keys.empty()) {
+                Store(keys.front(), Image(*img), ImageBytes(*img));
+            }
+        }
+
+        return *img;
+    };
+
+    last_applied_ = 0;
+
+    for (size_t i = start; i != filters.size(); ++i, ++last_applied_) {
+        const bool stored = i + 1 < keys.size();
+        const auto* edge = std::get_if<Node<EdgeDetectionFilter>>(&filters[i]);
+
+        if (stored && edge != nullptr) {
+            // a new threshold is compared with the stored response of the same input
+            const std::string response_key = keys[i] + ' ' + RESPONSE_KEY;
+
+            if (const EdgeResponse* response = Find<EdgeResponse>(response_key)) {
+                img = std::make_unique<Image>(0, 0, response->horizontal_resolution, response->vertical_resolution);
+                EdgeDetectionFilter::Threshold(*img, response->values, edge->parameters.threshold);
+            } else {
+                Image& input = materialize();
+                auto [horizontal_resolution, vertical_resolution] = input.Resolution();
+                EdgeResponse computed{EdgeDetectionFilter().Response(input), horizontal_resolution,
+                                      vertical_resolution};
+
+                EdgeDetectionFilter::Threshold(input, computed.values, edge->parameters.threshold);
+                Store(response_key, std::move(computed), ImageBytes(input) / sizeof(Pixel) * sizeof(double));
+            }
+        } else {
+            pipeline::Apply(filters[i], materialize());
+        }
+
+        // thresholds are cheap to compare again, so their results are not stored and a tuned threshold
+        // does not evict the other results
+        if (stored && edge == nullptr) {
+            Store(keys[i + 1], Image(*img), ImageBytes(*img));
+        }
+    }
+
+    materialize();
+    return img.release();
+}
+
+size_t RecomputeCache::LastApplied() const {
+    return last_applied_;
+}
+
+size_t RecomputeCache::Size() const {
+    return size_;
+}
+
+void RecomputeCache::Clear() {
+    recent_.clear();
+    entries_.clear();
+    size_ = 0;
+}
@@ -0,0 +1,341 @@
+#include "../utils/result_cache.h"
+#include "../utils/image_io.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+// changed when filters or codecs start producing other outputs for the same job
+const std::string CACHE_VERSION = "1";
+const std::string TEMPORARY_PREFIX = "tmp-";
+
+// temporary files older than this were left by processes which did not finish
+const std::chrono::hours STALE_TIME{1};
+
+const size_t READ_BLOCK_SIZE = 1 << 20;
+
+// 64-bit xxHash: the input is read in stripes of 32 bytes by four independent lanes, which keeps the hash
+// as fast as reading the file
+class Hasher {
+private:
+    static constexpr uint64_t PRIME1 = 11400714785074694791ull;
+    static constexpr uint64_t PRIME2 = 14029467366897019727ull;
+    static constexpr uint64_t PRIME3 = 1609587929392839161ull;
+    static constexpr uint64_t PRIME4 = 9650029242287828579ull;
+    static constexpr uint64_t PRIME5 = 2870177450012600261ull;
+    static constexpr size_t STRIPE_SIZE = 32;
+
+    std::array<uint64_t, 4> lanes_{PRIME1 + PRIME2, PRIME2, 0, -PRIME1};
+    std::array<uint8_t, STRIPE_SIZE> tail_{};
+    size_t tail_size_ = 0;
+    uint64_t total_size_ = 0;
+
+    static uint64_t Rotate(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static uint64_t Read64(const uint8_t* data) {
+        uint64_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static uint64_t Round(uint64_t lane, uint64_t input) {
+        return Rotate(lane + input * PRIME2, 31) * PRIME1;
+    }
+
+    static uint64_t Merge(uint64_t hash, uint64_t lane) {
+        return (hash ^ Round(0, lane)) * PRIME1 + PRIME4;
+    }
+
+    void Consume(const uint8_t* stripe) {
+        for (size_t i = 0; i != lanes_.size(); ++i) {
+            lanes_[i] = Round(lanes_[i], Read64(stripe + i * sizeof(uint64_t)));
+        }
+    }
+
+public:
+    void Update(const uint8_t* data, size_t size) {
+        total_size_ += size;
+
+        if (tail_size_ != 0) {
+            const size_t count = std::min(size, STRIPE_SIZE - tail_size_);
+            std::memcpy(tail_.data() + tail_size_, data, count);
+            tail_size_ += count;
+            data += count;
+            size -= count;
+
+            if (tail_size_ != STRIPE_SIZE) {
+                return;
+            }
+
+            Consume(tail_.data());
+            tail_size_ = 0;
+        }
+
+        for (; size >= STRIPE_SIZE; data += STRIPE_SIZE, size -= STRIPE_SIZE) {
+            Consume(data);
+        }
+
+        std::memcpy(tail_.data(), data, size);
+        tail_size_ = size;
+    }
+
+    void Update(const std::string& text) {
+        Update(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    }
+
+    uint64_t Finish() const {
+        uint64_t hash = PRIME5;
+
+        if (total_size_ >= STRIPE_SIZE) {
+            hash = Rotate(lanes_[0], 1) + Rotate(lanes_[1], 7) + Rotate(lanes_[2], 12) + Rotate(lanes_[3], 18);
+            for (uint64_t lane : lanes_) {
+                hash = Merge(hash, lane);
+            }
+        }
+
+        hash += total_size_;
+
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= tail_size_; i += sizeof(uint64_t)) {
+            hash = Rotate(hash ^ Round(0, Read64(tail_.data() + i)), 27) * PRIME1 + PRIME4;
+        }
+        if (i + sizeof(uint32_t) <= tail_size_) {
+            uint32_t value = 0;
+            std::memcpy(&value, tail_.data() + i, sizeof(value));
+            hash = Rotate(hash ^ (value * PRIME1), 23) * PRIME2 + PRIME3;
+            i += sizeof(uint32_t);
+        }
+        for (; i != tail_size_; ++i) {
+            hash = Rotate(hash ^ (tail_[i] * PRIME5), 11) * PRIME1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= PRIME2;
+        hash ^= hash >> 29;
+        hash *= PRIME3;
+        hash ^= hash >> 32;
+
+        return hash;
+    }
+};
+
+std::string Hex(uint64_t value) {
+    std::ostringstream text;
+    text << std::hex;
+    text.width(16);
+    text.fill('0');
+    text << value;
+    return text.str();
+}
+
+bool IsTemporary(const std::filesystem::path& path) {
+    return path.filename().string().starts_with(TEMPORARY_PREFIX);
+}
+
+// two hashes of 16 digits, other files in the directory are not evicted
+bool IsStored(const std::filesystem::path& path) {
+    const std::string name = path.filename().string();
+    const size_t separator = 2 * sizeof(uint64_t);
+
+    if (name.size() <= 2 * separator + 1 || name[separator] != '-') {
+        return false;
+    }
+
+    return std::all_of(name.begin(), name.begin() + 2 * separator + 1,
+                       [](unsigned char c) { return c == '-' || std::isxdigit(c); });
+}
+
+// copies the file to the output path of the job
+void CopyOutput(std::ifstream& f, const Pipeline& pipeline) {
+    if (pipeline.output_path == image_io::STANDARD_STREAM) {
+        std::cout << f.rdbuf();
+        std::cout.flush();
+        return;
+    }
+
+    std::ofstream output(pipeline.output_path, std::ios::out | std::ios::binary);
+    if (!output.is_open()) {
+        throw FileCreationError{};
+    }
+
+    output << f.rdbuf();
+}
+
+// output files with the time of their last use
+struct StoredFile {
+    std::filesystem::file_time_type used;
+    uint64_t size;
+    std::filesystem::path path;
+};
+}  // namespace
+
+const uint64_t ResultCache::DEFAULT_CAPACITY = 1ull << 30;
+
+ResultCache::ResultCache(std::string directory, uint64_t capacity)
+    : directory_(std::move(directory)), capacity_(capacity) {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+
+    if (!std::filesystem::is_directory(directory_)) {
+        throw FileCreationError{};
+    }
+}
+
+uint64_t ResultCache::HashFile(const std::string& file_path) {
+    const auto hash = file_hashes_.find(file_path);
+    if (hash != file_hashes_.end()) {
+        return hash->second;
+    }
+
+    std::ifstream f(file_path, std::ios::in | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileNotFoundError{};
+    }
+
+    Hasher hasher;
+    std::vector<char> block(READ_BLOCK_SIZE);
+
+    while (f) {
+        f.read(block.data(), static_cast<std::streamsize>(block.size()));
+        hasher.Update(reinterpret_cast<const uint8_t*>(block.data()), static_cast<size_t>(f.gcount()));
+    }
+
+    return file_hashes_[file_path] = hasher.Finish();
+}
+
+std::optional<std::string> ResultCache::Key(const Pipeline& pipeline) {
+    if (pipeline.input_path == image_io::STANDARD_STREAM) {
+        return std::nullopt;
+    }
+
+    const ReadOptions& read = pipeline.read_options;
+    const WriteOptions& write = pipeline.write_options;
+    const std::string format = image_io::OutputFormat(pipeline.output_path, write);
+
+    // everything the output depends on except the pixels of the files
+    std::ostringstream job;
+    job << CACHE_VERSION << '\n'
+        << pipeline.description << '\n'
+        << read.scale << ' ' << static_cast<int>(read.scale_method) << ' ' << read.frame_width << ' '
+        << read.frame_height << ' ' << static_cast<int>(read.matrix) << ' ' << read.luma_only << ' ' << read.format
+        << '\n'
+        << static_cast<int>(write.depth) << ' ' << static_cast<int>(write.sample_bits) << ' ' << write.tile_size << ' '
+        << format;
+
+    if (read.window.has_value()) {
+        job << '\n' << read.window->top << ' ' << read.window->left << ' ' << read.window->height << ' '
+            << read.window->width;
+    }
+
+    Hasher files;
+    const uint64_t input_hash = HashFile(pipeline.input_path);
+    files.Update(reinterpret_cast<const uint8_t*>(&input_hash), sizeof(input_hash));
+
+    for (const FilterNode& filter : pipeline.filters) {
+        if (const auto* masked = std::get_if<Node<MaskedFilter>>(&filter)) {
+            const uint64_t mask_hash = HashFile(masked->parameters.path);
+            files.Update(reinterpret_cast<const uint8_t*>(&mask_hash), sizeof(mask_hash));
+        }
+    }
+
+    Hasher job_hasher;
+    job_hasher.Update(job.str());
+
+    return Hex(files.Finish()) + '-' + Hex(job_hasher.Finish()) + format;
+}
+
+bool ResultCache::Fetch(const std::string& key, const Pipeline& pipeline) const {
+    const std::filesystem::path stored = std::filesystem::path(directory_) / key;
+
+    // an opened file is read to the end even if another process removes it
+    std::ifstream f(stored, std::ios::in | std::ios::binary);
+    if (!f.is_open()) {
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::last_write_time(stored, std::filesystem::file_time_type::clock::now(), error);
+    CopyOutput(f, pipeline);
+
+    return true;
+}
+
+std::string ResultCache::TemporaryPath(const Pipeline& pipeline) const {
+    static std::atomic<uint64_t> counter = 0;
+
+    const std::string name = TEMPORARY_PREFIX + std::to_string(getpid()) + '-' + std::to_string(counter++) +
+                             image_io::OutputFormat(pipeline.output_path, pipeline.write_options);
+
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+void ResultCache::Store(const std::string& key, const std::string& temporary_path, const Pipeline& pipeline) const {
+    // the output is copied before it is stored, so other processes evicting it can not remove it first
+    {
+        std::ifstream f(temporary_path, std::ios::in | std::ios::binary);
+        if (!f.is_open()) {
+            throw FileNotFoundError{};
+        }
+
+        CopyOutput(f, pipeline);
+    }
+
+    // the rename replaces an output stored by another process at the same time with an equal one
+    std::filesystem::rename(temporary_path, std::filesystem::path(directory_) / key);
+    Evict();
+}
+
+void ResultCache::Evict() const {
+    std::vector<StoredFile> files;
+    uint64_t total_size = 0;
+    const auto now = std::filesystem::file_time_type::clock::now();
+
+    // other processes add and remove files meanwhile, files which disappear are skipped
+    std::error_code error;
+    for (auto entry = std::filesystem::directory_iterator(directory_, error);
+         !error && entry != std::filesystem::directory_iterator(); entry.increment(error)) {
+        std::error_code file_error;
+        const auto used = entry->last_write_time(file_error);
+        const uint64_t size = entry->file_size(file_error);
+
+        if (file_error || !entry->is_regular_file(file_error)) {
+            continue;
+        }
+
+        if (IsTemporary(entry->path())) {
+            if (now - used > STALE_TIME) {
+                std::filesystem::remove(entry->path(), file_error);
+            }
+            continue;
+        }
+
+        if (!IsStored(entry->path())) {
+            continue;
+        }
+
+        files.push_back({used, size, entry->path()});
+        total_size += size;
+    }
+
+    std::sort(files.begin(), files.end(),
+              [](const StoredFile& lhs, const StoredFile& rhs) { return lhs.used < rhs.used; });
+
+    for (size_t i = 0; i != files.size() && total_size > capacity_; ++i) {
+        std::filesystem::remove(files[i].path, error);
+        total_size -= files[i].size;
+    }
+}
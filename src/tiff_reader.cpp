@@ -0,0 +1,679 @@
+#include "../utils/tiff_reader.h"
+#include "../utils/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace {
+const uint8_t BYTE = 8;
+const uint32_t MAX_8_BITS_SAMPLE = UINT8_MAX;
+const uint32_t MAX_SAMPLE = UINT16_MAX;
+
+const uint16_t CLASSIC_VERSION = 42;
+const uint16_t BIG_VERSION = 43;
+const std::string BIG_TIFF_EXTENSION = ".btf";
+const uint64_t CLASSIC_LIMIT = UINT32_MAX;
+const int64_t STRIP_SIZE = 1 << 16;  // approximate size of written strips in bytes
+const int64_t TILE_ALIGNMENT = 16;   // tile sides have to be multiples of 16
+const int64_t CHUNKS_PER_THREAD = 4;  // chunks encoded by every thread before they are written
+
+const double METERS_PER_INCH = 0.0254;
+const double CENTIMETERS_PER_METER = 100;
+
+enum TAG : uint16_t {
+    image_width = 256,
+    image_length = 257,
+    bits_per_sample = 258,
+    compression = 259,
+    photometric_interpretation = 262,
+    strip_offsets = 273,
+    samples_per_pixel = 277,
+    rows_per_strip = 278,
+    strip_byte_counts = 279,
+    x_resolution = 282,
+    y_resolution = 283,
+    planar_configuration = 284,
+    resolution_unit = 296,
+    tile_width = 322,
+    tile_length = 323,
+    tile_offsets = 324,
+    tile_byte_counts = 325
+};
+
+enum FIELD_TYPE : uint16_t { short_integer = 3, long_integer = 4, rational = 5, long8_integer = 16 };
+
+enum PHOTOMETRIC : uint16_t { white_is_zero = 0, black_is_zero = 1, rgb = 2 };
+
+enum RESOLUTION_UNIT : uint16_t { no_unit = 1, inch = 2, centimeter = 3 };
+
+uint64_t FieldTypeSize(uint16_t type) {
+    switch (type) {
+        case 1:  // BYTE
+        case 2:  // ASCII
+        case 6:  // SBYTE
+        case 7:  // UNDEFINED
+            return 1;
+        case 3:  // SHORT
+        case 8:  // SSHORT
+            return 2;
+        case 4:   // LONG
+        case 9:   // SLONG
+        case 11:  // FLOAT
+        case 13:  // IFD
+            return 4;
+        case 5:   // RATIONAL
+        case 10:  // SRATIONAL
+        case 12:  // DOUBLE
+        case 16:  // LONG8
+        case 17:  // SLONG8
+        case 18:  // IFD8
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+// integer fields hold one value per element, rationals hold numerator and denominator
+using Fields = std::map<uint16_t, std::vector<uint64_t>>;
+
+class Decoder {
+private:
+    std::istream& f_;
+    bool big_endian_ = false;
+    bool big_tiff_ = false;
+
+public:
+    explicit Decoder(std::istream& f) : f_(f) {
+    }
+
+    uint64_t Number(const uint8_t* bytes, uint64_t size) const {
+        uint64_t number = 0;
+
+        for (uint64_t i = 0; i != size; ++i) {
+            const uint64_t byte = bytes[big_endian_ ? i : size - 1 - i];
+            number = (number << BYTE) | byte;
+        }
+
+        return number;
+    }
+
+    uint64_t ReadNumber(uint64_t size) {
+        uint8_t bytes[BYTE];
+        f_.read(reinterpret_cast<char*>(bytes), static_cast<std::streamsize>(size));
+
+        if (!f_) {
+            throw UnsupportedFileFormat{"Truncated TIFF header"};
+        }
+
+        return Number(bytes, size);
+    }
+
+    bool BigEndian() const {
+        return big_endian_;
+    }
+
+    // returns the offset of the first IFD
+    uint64_t ParseHeader(const std::string& file_path) {
+        char order[2];
+        f_.read(order, 2);
+
+        if (!f_ || order[0] != order[1] || (order[0] != 'I' && order[0] != 'M')) {
+            throw UnsupportedFileFormat{file_path};
+        }
+
+        big_endian_ = order[0] == 'M';
+        const uint64_t version = ReadNumber(2);
+
+        if (version == CLASSIC_VERSION) {
+            return ReadNumber(4);
+        }
+
+        if (version != BIG_VERSION || ReadNumber(2) != BYTE || ReadNumber(2) != 0) {
+            throw UnsupportedFileFormat{file_path};
+        }
+
+        big_tiff_ = true;
+        return ReadNumber(BYTE);
+    }
+
+    Fields ParseDirectory(uint64_t offset) {
+        f_.seekg(static_cast<std::streamoff>(offset));
+
+        const uint64_t entries_count = ReadNumber(big_tiff_ ? 8 : 2);
+        const uint64_t entry_size = big_tiff_ ? 20 : 12;
+        const uint64_t slot_size = big_tiff_ ? 8 : 4;
+
+        std::vector<uint8_t> entries(entries_count * entry_size);
+        f_.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size()));
+
+        if (!f_) {
+            throw UnsupportedFileFormat{"Truncated TIFF directory"};
+        }
+
+        Fields fields;
+        for (uint64_t i = 0; i != entries_count; ++i) {
+            const uint8_t* entry = &entries[i * entry_size];
+            const auto tag = static_cast<uint16_t>(Number(entry, 2));
+            const auto type = static_cast<uint16_t>(Number(entry + 2, 2));
+            const uint64_t count = Number(entry + 4, slot_size);
+            const uint8_t* slot = entry + 4 + slot_size;
+
+            if (type != short_integer && type != long_integer && type != rational && type != long8_integer) {
+                continue;
+            }
+
+            // values which do not fit into the entry are stored at the offset from the entry
+            const uint64_t type_size = FieldTypeSize(type);
+            std::vector<uint8_t> data(count * type_size);
+
+            if (data.size() <= slot_size) {
+                std::copy(slot, slot + data.size(), data.begin());
+            } else {
+                f_.seekg(static_cast<std::streamoff>(Number(slot, slot_size)));
+                f_.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+                if (!f_) {
+                    throw UnsupportedFileFormat{"Truncated TIFF directory"};
+                }
+            }
+
+            const uint64_t value_size = type == rational ? type_size / 2 : type_size;
+            std::vector<uint64_t>& values = fields[tag];
+
+            for (uint64_t j = 0; j != data.size() / value_size; ++j) {
+                values.push_back(Number(&data[j * value_size], value_size));
+            }
+        }
+
+        return fields;
+    }
+};
+
+uint64_t Field(const Fields& fields, uint16_t tag, uint64_t default_value) {
+    const auto it = fields.find(tag);
+    return it == fields.end() || it->second.empty() ? default_value : it->second.front();
+}
+
+const std::vector<uint64_t>& RequiredField(const Fields& fields, uint16_t tag) {
+    const auto it = fields.find(tag);
+
+    if (it == fields.end() || it->second.empty()) {
+        throw UnsupportedFileFormat{"Missing TIFF tag " + std::to_string(tag)};
+    }
+
+    return it->second;
+}
+
+// pixels per meter
+size_t Resolution(const Fields& fields, uint16_t tag, uint64_t unit) {
+    const auto it = fields.find(tag);
+
+    if (it == fields.end() || it->second.size() < 2 || it->second[1] == 0 || unit == no_unit) {
+        return 0;
+    }
+
+    const double value = static_cast<double>(it->second[0]) / static_cast<double>(it->second[1]);
+    return std::lround(unit == centimeter ? value * CENTIMETERS_PER_METER : value / METERS_PER_INCH);
+}
+
+// strips are stored as tiles of the full image width
+struct Layout {
+    int64_t width;
+    int64_t height;
+    int64_t samples_per_pixel;
+    int64_t sample_size;
+    uint64_t photometric;
+    int64_t chunk_width;
+    int64_t chunk_height;
+    int64_t chunks_across;
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> byte_counts;
+};
+
+Layout ParseLayout(const Fields& fields) {
+    Layout layout{};
+    layout.width = static_cast<int64_t>(RequiredField(fields, image_width).front());
+    layout.height = static_cast<int64_t>(RequiredField(fields, image_length).front());
+    layout.samples_per_pixel = static_cast<int64_t>(Field(fields, samples_per_pixel, 1));
+    layout.photometric = RequiredField(fields, photometric_interpretation).front();
+
+    // all channels have to share the sample size
+    const uint64_t bits = Field(fields, bits_per_sample, 1);
+    const auto channels_bits = fields.find(bits_per_sample);
+    if ((bits != BYTE && bits != 2 * BYTE) ||
+        (channels_bits != fields.end() &&
+         std::count(channels_bits->second.begin(), channels_bits->second.end(), bits) !=
+             static_cast<int64_t>(channels_bits->second.size()))) {
+        throw UnsupportedFileFormat{"TIFF with " + std::to_string(bits) + " bits samples"};
+    }
+    layout.sample_size = static_cast<int64_t>(bits / BYTE);
+
+    if (Field(fields, compression, 1) != 1) {
+        throw UnsupportedFileFormat{"Compressed TIFF"};
+    }
+    if (layout.samples_per_pixel > 1 && Field(fields, planar_configuration, 1) != 1) {
+        throw UnsupportedFileFormat{"Planar TIFF"};
+    }
+    if (layout.photometric > rgb || (layout.photometric == rgb) != (layout.samples_per_pixel >= 3)) {
+        throw UnsupportedFileFormat{"TIFF photometric interpretation " + std::to_string(layout.photometric)};
+    }
+    if (layout.width <= 0 || layout.height <= 0) {
+        throw UnsupportedFileFormat{"Wrong TIFF size"};
+    }
+
+    if (fields.count(tile_offsets)) {
+        layout.chunk_width = static_cast<int64_t>(RequiredField(fields, tile_width).front());
+        layout.chunk_height = static_cast<int64_t>(RequiredField(fields, tile_length).front());
+        layout.offsets = fields.at(tile_offsets);
+        layout.byte_counts = RequiredField(fields, tile_byte_counts);
+    } else {
+        layout.chunk_width = layout.width;
+        layout.chunk_height = std::min(layout.height, static_cast<int64_t>(Field(fields, rows_per_strip, UINT32_MAX)));
+        layout.offsets = RequiredField(fields, strip_offsets);
+        layout.byte_counts = RequiredField(fields, strip_byte_counts);
+    }
+
+    if (layout.chunk_width <= 0 || layout.chunk_height <= 0) {
+        throw UnsupportedFileFormat{"Wrong TIFF chunk size"};
+    }
+
+    layout.chunks_across = (layout.width + layout.chunk_width - 1) / layout.chunk_width;
+    const int64_t chunks_down = (layout.height + layout.chunk_height - 1) / layout.chunk_height;
+
+    if (static_cast<int64_t>(layout.offsets.size()) < layout.chunks_across * chunks_down ||
+        layout.byte_counts.size() < layout.offsets.size()) {
+        throw UnsupportedFileFormat{"Missing TIFF strips"};
+    }
+
+    return layout;
+}
+
+// copies the part of the chunk inside source into rgb samples of the source, gray samples are repeated
+void DecodeChunk(std::istream& f, const Layout& layout, int64_t chunk, const ImageBuilder& builder,
+                 bool big_endian, std::vector<uint8_t>& data, std::vector<uint16_t>& rgb_samples) {
+    const Region& source = builder.Source();
+    const int64_t top = chunk / layout.chunks_across * layout.chunk_height;
+    const int64_t left = chunk % layout.chunks_across * layout.chunk_width;
+
+    const int64_t first_row = std::max(top, source.top);
+    const int64_t last_row = std::min({top + layout.chunk_height, source.top + source.height, layout.height});
+    const int64_t first_column = std::max(left, source.left);
+    const int64_t last_column = std::min({left + layout.chunk_width, source.left + source.width, layout.width});
+
+    const int64_t pixel_size = layout.samples_per_pixel * layout.sample_size;
+    const int64_t row_size = layout.chunk_width * pixel_size;
+
+    // the needed rows of the chunk are read at once
+    const uint64_t begin = (first_row - top) * row_size;
+    const uint64_t end = (last_row - top - 1) * row_size + (last_column - left) * pixel_size;
+
+    if (end > layout.byte_counts[chunk]) {
+        throw UnsupportedFileFormat{"Truncated TIFF strip"};
+    }
+
+    data.resize(end - begin);
+    f.seekg(static_cast<std::streamoff>(layout.offsets[chunk] + begin));
+    f.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+    if (!f) {
+        throw UnsupportedFileFormat{"Truncated TIFF strip"};
+    }
+
+    const int64_t channels = layout.photometric == rgb ? 3 : 1;
+    const uint16_t max_value = layout.sample_size == 1 ? MAX_8_BITS_SAMPLE : MAX_SAMPLE;
+
+    for (int64_t y = first_row; y != last_row; ++y) {
+        if (!builder.IsRowNeeded(y)) {
+            continue;
+        }
+
+        const uint8_t* pixel = &data[(y - first_row) * row_size + (first_column - left) * pixel_size];
+        uint16_t* samples = &rgb_samples[3 * ((y - source.top) * source.width + first_column - source.left)];
+
+        for (int64_t x = first_column; x != last_column; ++x, pixel += pixel_size) {
+            for (int64_t c = 0; c != 3; ++c) {
+                const uint8_t* sample = pixel + (channels == 1 ? 0 : c) * layout.sample_size;
+                uint16_t value = sample[0];
+
+                if (layout.sample_size == 2) {
+                    value = big_endian ? (sample[0] << BYTE) | sample[1] : (sample[1] << BYTE) | sample[0];
+                }
+
+                *samples++ = layout.photometric == white_is_zero ? max_value - value : value;
+            }
+        }
+    }
+}
+
+// seekable stream over bytes kept in memory
+class MemoryBuffer : public std::streambuf {
+public:
+    explicit MemoryBuffer(const std::string& data) {
+        char* begin = const_cast<char*>(data.data());
+        setg(begin, begin, begin + data.size());
+    }
+
+protected:
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override {
+        char* position = (direction == std::ios_base::beg ? eback() : direction == std::ios_base::cur ? gptr() : egptr());
+
+        if (!(which & std::ios_base::in) || offset < eback() - position || offset > egptr() - position) {
+            return pos_type(off_type(-1));
+        }
+
+        setg(eback(), position + offset, egptr());
+        return gptr() - eback();
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+        return seekoff(off_type(position), std::ios_base::beg, which);
+    }
+};
+
+class MemoryStream : public std::istream {
+private:
+    MemoryBuffer buffer_;
+
+public:
+    explicit MemoryStream(const std::string& data) : std::istream(nullptr), buffer_(data) {
+        rdbuf(&buffer_);
+    }
+};
+
+// little endian values of the given size
+void Append(std::vector<uint8_t>& bytes, uint64_t value, uint64_t size) {
+    for (uint64_t i = 0; i != size; ++i) {
+        bytes.push_back((value >> (BYTE * i)) & MAX_8_BITS_SAMPLE);
+    }
+}
+
+struct Entry {
+    uint16_t tag;
+    uint16_t type;
+    uint64_t count;
+    std::vector<uint8_t> data;
+};
+
+Entry MakeEntry(uint16_t tag, uint16_t type, const std::vector<uint64_t>& values) {
+    const uint64_t value_size = type == rational ? FieldTypeSize(type) / 2 : FieldTypeSize(type);
+    Entry entry{tag, type, type == rational ? values.size() / 2 : values.size(), {}};
+
+    for (uint64_t value : values) {
+        Append(entry.data, value, value_size);
+    }
+
+    return entry;
+}
+
+// rows of the image inside the chunk, tiles are padded with zeros
+void EncodeChunk(Image* img, int64_t top, int64_t left, int64_t chunk_height, int64_t chunk_width,
+                 int64_t channels, int64_t sample_size, std::vector<uint8_t>& data) {
+    auto [height, width] = img->Shape();
+    const int64_t rows = std::min(chunk_height, height - top);
+
+    data.assign(rows * chunk_width * channels * sample_size, 0);
+    uint8_t* sample = data.data();
+
+    for (int64_t y = top; y != top + rows; ++y) {
+        const std::vector<Pixel>& pixels = img->GetPixels()[y];
+
+        for (int64_t x = left; x != left + chunk_width; ++x) {
+            if (x >= width) {
+                sample += channels * sample_size;
+                continue;
+            }
+
+            const Pixel& pixel = pixels[x];
+            const double colors[] = {pixel.r, pixel.g, pixel.b};
+
+            for (int64_t c = 0; c != channels; ++c) {
+                const double color = channels == 1 ? GrayLevel(pixel) : colors[c];
+
+                if (sample_size == 1) {
+                    *sample++ = static_cast<uint8_t>(color * MAX_8_BITS_SAMPLE);
+                } else {
+                    const auto value = static_cast<uint16_t>(std::lround(color * MAX_SAMPLE));
+                    *sample++ = value & MAX_8_BITS_SAMPLE;
+                    *sample++ = value >> BYTE;
+                }
+            }
+        }
+    }
+}
+
+// open() returns a new stream of the file, so every thread reads the file with its own stream
+template <typename OpenStream>
+Image* Decode(OpenStream open, const ReadOptions& options, const std::string& name) {
+    // only the first image of the file is read
+    auto f = open();
+    Decoder decoder(*f);
+    const Fields fields = decoder.ParseDirectory(decoder.ParseHeader(name));
+    const Layout layout = ParseLayout(fields);
+    f.reset();
+
+    const uint64_t unit = Field(fields, resolution_unit, inch);
+    ImageBuilder builder(layout.height, layout.width, Resolution(fields, x_resolution, unit),
+                         Resolution(fields, y_resolution, unit), options);
+    const Region& source = builder.Source();
+
+    std::vector<int64_t> chunks;
+    for (int64_t cy = source.top / layout.chunk_height;
+         cy * layout.chunk_height < source.top + source.height; ++cy) {
+        for (int64_t cx = source.left / layout.chunk_width;
+             cx * layout.chunk_width < source.left + source.width; ++cx) {
+            chunks.push_back(cy * layout.chunks_across + cx);
+        }
+    }
+
+    // chunks cover disjoint parts of the samples, so every thread decodes its chunks with its own stream
+    std::vector<uint16_t> rgb_samples(3 * source.height * source.width);
+    ParallelFor(static_cast<int64_t>(chunks.size()), [&](int64_t begin, int64_t end) {
+        auto chunk_file = open();
+        std::vector<uint8_t> data;
+
+        for (int64_t i = begin; i != end; ++i) {
+            DecodeChunk(*chunk_file, layout, chunks[i], builder, decoder.BigEndian(), data, rgb_samples);
+        }
+    });
+
+    const int64_t scale = builder.Scale();
+    const double max_value = layout.sample_size == 1 ? MAX_8_BITS_SAMPLE : MAX_SAMPLE;
+
+    ParallelFor((source.height + scale - 1) / scale, [&](int64_t begin, int64_t end) {
+        for (int64_t y = source.top + begin * scale; y < std::min(source.top + end * scale, source.top + source.height);
+             ++y) {
+            builder.AddRow(y, &rgb_samples[3 * (y - source.top) * source.width], max_value);
+        }
+    });
+
+    Image* img = builder.Release();
+
+    if (layout.photometric != rgb) {
+        img->SetColorMode(ColorMode::grayscale);
+    }
+
+    return img;
+}
+}  // namespace
+
+Image* tiff_reader::ReadFile(const std::string& file_path, Image* img, const ReadOptions& options) {
+    const auto open = [&file_path]() {
+        auto f = std::make_unique<std::ifstream>(file_path, std::ios::in | std::ios::binary);
+
+        if (!f->is_open()) {
+            throw FileNotFoundError{};
+        }
+
+        return f;
+    };
+
+    return Decode(open, options, file_path);
+}
+
+Image* tiff_reader::ReadStream(std::istream& f, Image* img, const ReadOptions& options) {
+    // directories and strips can be anywhere in the file, so a stream which cannot seek is read into memory
+    std::ostringstream buffer;
+    buffer << f.rdbuf();
+    const std::string data = buffer.str();
+
+    return Decode([&data]() { return std::make_unique<MemoryStream>(data); }, options, "Input stream");
+}
+
+void tiff_reader::SaveFile(const std::string& output_path, Image* img, const WriteOptions& options) {
+    std::fstream f;
+    f.open(output_path, std::ios::out | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileCreationError{};
+    }
+
+    SaveStream(f, img, options, std::filesystem::path(output_path).extension().string());
+    f.close();
+}
+
+void tiff_reader::SaveStream(std::ostream& f, Image* img, const WriteOptions& options, const std::string& extension) {
+    auto [height, width] = img->Shape();
+    auto [horizontal_resolution, vertical_resolution] = img->Resolution();
+
+    ColorDepth depth = options.depth;
+    if (depth == ColorDepth::automatic) {
+        depth = DetectColorDepth(*img);
+    }
+
+    const int64_t channels = depth == ColorDepth::rgb ? 3 : 1;
+    const int64_t sample_size = options.sample_bits == 2 * BYTE ? 2 : 1;
+    const int64_t row_size = width * channels * sample_size;
+
+    const bool tiled = options.tile_size > 0;
+    if (tiled && options.tile_size % TILE_ALIGNMENT != 0) {
+        throw InvalidArgumentsError{};
+    }
+
+    const int64_t chunk_width = tiled ? options.tile_size : width;
+    const int64_t chunk_height =
+        tiled ? options.tile_size : std::clamp(STRIP_SIZE / std::max<int64_t>(row_size, 1), int64_t{1}, height);
+    const int64_t chunks_across = (width + chunk_width - 1) / chunk_width;
+    const int64_t chunks_count = chunks_across * ((height + chunk_height - 1) / chunk_height);
+
+    std::vector<uint64_t> byte_counts(chunks_count);
+    uint64_t data_size = 0;
+
+    for (int64_t i = 0; i != chunks_count; ++i) {
+        const int64_t rows = tiled ? chunk_height : std::min(chunk_height, height - i * chunk_height);
+        byte_counts[i] = rows * chunk_width * channels * sample_size;
+        data_size += byte_counts[i];
+    }
+
+    // directory and its values take about 16 bytes per chunk
+    const bool big_tiff = extension == BIG_TIFF_EXTENSION ||
+                          data_size + 2 * BYTE * chunks_count + STRIP_SIZE > CLASSIC_LIMIT;
+
+    const uint64_t header_size = big_tiff ? 16 : 8;
+    const uint64_t offset_size = big_tiff ? 8 : 4;
+    const uint16_t offset_type = big_tiff ? long8_integer : long_integer;
+
+    std::vector<uint64_t> offsets(chunks_count);
+    for (int64_t i = 0; i != chunks_count; ++i) {
+        offsets[i] = i == 0 ? header_size : offsets[i - 1] + byte_counts[i - 1];
+    }
+
+    // resolution is saved in pixels per centimeter
+    std::vector<Entry> entries = {
+        MakeEntry(image_width, long_integer, {static_cast<uint64_t>(width)}),
+        MakeEntry(image_length, long_integer, {static_cast<uint64_t>(height)}),
+        MakeEntry(bits_per_sample, short_integer,
+                  std::vector<uint64_t>(channels, static_cast<uint64_t>(sample_size * BYTE))),
+        MakeEntry(compression, short_integer, {1}),
+        MakeEntry(photometric_interpretation, short_integer, {channels == 3 ? rgb : black_is_zero}),
+        MakeEntry(samples_per_pixel, short_integer, {static_cast<uint64_t>(channels)}),
+        MakeEntry(x_resolution, rational, {horizontal_resolution, static_cast<uint64_t>(CENTIMETERS_PER_METER)}),
+        MakeEntry(y_resolution, rational, {vertical_resolution, static_cast<uint64_t>(CENTIMETERS_PER_METER)}),
+        MakeEntry(planar_configuration, short_integer, {1}),
+        MakeEntry(resolution_unit, short_integer, {centimeter}),
+    };
+
+    if (tiled) {
+        entries.push_back(MakeEntry(tile_width, long_integer, {static_cast<uint64_t>(chunk_width)}));
+        entries.push_back(MakeEntry(tile_length, long_integer, {static_cast<uint64_t>(chunk_height)}));
+        entries.push_back(MakeEntry(tile_offsets, offset_type, offsets));
+        entries.push_back(MakeEntry(tile_byte_counts, offset_type, byte_counts));
+    } else {
+        entries.push_back(MakeEntry(strip_offsets, offset_type, offsets));
+        entries.push_back(MakeEntry(rows_per_strip, long_integer, {static_cast<uint64_t>(chunk_height)}));
+        entries.push_back(MakeEntry(strip_byte_counts, offset_type, byte_counts));
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.tag < b.tag; });
+
+    // the directory follows the data, values which do not fit into the entries follow the directory
+    const uint64_t directory_offset = header_size + data_size + data_size % 2;
+    const uint64_t values_offset =
+        directory_offset + (big_tiff ? 8 : 2) + entries.size() * (big_tiff ? 20 : 12) + offset_size;
+
+    std::vector<uint8_t> directory;
+    std::vector<uint8_t> values;
+
+    Append(directory, entries.size(), big_tiff ? 8 : 2);
+    for (const Entry& entry : entries) {
+        Append(directory, entry.tag, 2);
+        Append(directory, entry.type, 2);
+        Append(directory, entry.count, offset_size);
+
+        if (entry.data.size() <= offset_size) {
+            directory.insert(directory.end(), entry.data.begin(), entry.data.end());
+            Append(directory, 0, offset_size - entry.data.size());
+        } else {
+            Append(directory, values_offset + values.size(), offset_size);
+            values.insert(values.end(), entry.data.begin(), entry.data.end());
+            Append(values, 0, values.size() % 2);
+        }
+    }
+    Append(directory, 0, offset_size);  // no next directory
+
+    std::vector<uint8_t> header = {'I', 'I'};
+    if (big_tiff) {
+        Append(header, BIG_VERSION, 2);
+        Append(header, BYTE, 2);
+        Append(header, 0, 2);
+        Append(header, directory_offset, BYTE);
+    } else {
+        Append(header, CLASSIC_VERSION, 2);
+        Append(header, directory_offset, 4);
+    }
+
+    f.write(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+    // chunks are encoded in parallel batches and written in order
+    const int64_t batch_size =
+        CHUNKS_PER_THREAD * static_cast<int64_t>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::vector<uint8_t>> batch(std::min(batch_size, chunks_count));
+
+    for (int64_t first = 0; first < chunks_count; first += batch_size) {
+        const int64_t count = std::min(batch_size, chunks_count - first);
+
+        ParallelFor(count, [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i != end; ++i) {
+                const int64_t chunk = first + i;
+                EncodeChunk(img, chunk / chunks_across * chunk_height, chunk % chunks_across * chunk_width,
+                            chunk_height, chunk_width, channels, sample_size, batch[i]);
+                batch[i].resize(byte_counts[chunk], 0);
+            }
+        });
+
+        for (int64_t i = 0; i != count; ++i) {
+            f.write(reinterpret_cast<char*>(batch[i].data()), static_cast<std::streamsize>(batch[i].size()));
+        }
+    }
+
+    if (data_size % 2 != 0) {
+        f.put(0);
+    }
+
+    f.write(reinterpret_cast<char*>(directory.data()), static_cast<std::streamsize>(directory.size()));
+    f.write(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(values.size()));
+}
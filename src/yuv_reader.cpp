@@ -0,0 +1,241 @@
+#include "../utils/yuv_reader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+namespace {
+const std::string NV12_EXTENSION = ".nv12";
+
+// limited range of 8-bit samples
+const double BLACK_LEVEL = 16;
+const double LUMA_RANGE = 219;
+const double CHROMA_ZERO = 128;
+const double CHROMA_RANGE = 224;
+const double MAX_SAMPLE = UINT8_MAX;
+
+struct Coefficients {
+    double red;   // luma weights
+    double green;
+    double blue;
+    double red_v;  // weights of chroma differences Pb = (U - 128) / 224 and Pr = (V - 128) / 224
+    double green_u;
+    double green_v;
+    double blue_u;
+};
+
+Coefficients MatrixCoefficients(YuvMatrix matrix) {
+    const double red = matrix == YuvMatrix::bt601 ? 0.299 : 0.2126;   // NOLINT
+    const double blue = matrix == YuvMatrix::bt601 ? 0.114 : 0.0722;  // NOLINT
+    const double green = 1 - red - blue;
+
+    return {red, green, blue, 2 * (1 - red), -2 * (1 - blue) * blue / green, -2 * (1 - red) * red / green,
+            2 * (1 - blue)};
+}
+
+// both formats keep the luma plane first and one chroma pair for every 2 x 2 block after it
+struct Layout {
+    int64_t width;
+    int64_t height;
+    int64_t chroma_width;
+    int64_t chroma_height;
+    bool interleaved;  // NV12 stores U and V of a block next to each other
+
+    int64_t FrameSize() const {
+        return width * height + 2 * chroma_width * chroma_height;
+    }
+
+    // offsets of the first U and V samples of a chroma row
+    std::streamoff UOffset(int64_t row) const {
+        return width * height + (interleaved ? 2 : 1) * row * chroma_width;
+    }
+
+    std::streamoff VOffset(int64_t row) const {
+        return interleaved ? UOffset(row) + 1 : UOffset(row) + chroma_width * chroma_height;
+    }
+
+    // distance between samples of one channel
+    int64_t ChromaStep() const {
+        return interleaved ? 2 : 1;
+    }
+};
+
+Layout MakeLayout(const std::string& extension, int64_t width, int64_t height) {
+    return {width, height, (width + 1) / 2, (height + 1) / 2, extension == NV12_EXTENSION};
+}
+
+void ReadBytes(std::istream& f, std::streamoff offset, int64_t count, std::vector<uint8_t>& bytes) {
+    bytes.resize(count);
+    f.seekg(offset);
+    f.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(count));
+
+    if (!f) {
+        throw UnsupportedFileFormat{"Truncated raster"};
+    }
+}
+
+uint8_t Quantize(double sample) {
+    return static_cast<uint8_t>(std::clamp(std::round(sample), 0., MAX_SAMPLE));
+}
+}  // namespace
+
+Image* yuv_reader::ReadFile(const std::string& file_path, Image* img, const ReadOptions& options) {
+    std::ifstream f;
+    f.open(file_path, std::ios::in | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileNotFoundError{};
+    }
+
+    return ReadStream(f, img, options, std::filesystem::path(file_path).extension().string());
+}
+
+Image* yuv_reader::ReadStream(std::istream& f, Image* img, const ReadOptions& options, const std::string& extension) {
+    if (options.frame_width <= 0 || options.frame_height <= 0) {
+        throw InvalidArgumentsError{};
+    }
+
+    // frames have at most 2 bytes per pixel, the input has to hold the whole frame before it is allocated
+    CheckRasterSize(options.frame_height, options.frame_width, 2, "YUV");
+    const Layout layout = MakeLayout(extension, options.frame_width, options.frame_height);
+    CheckRemainingBytes(f, layout.FrameSize());
+
+    ImageBuilder builder(layout.height, layout.width, 0, 0, options);
+    const Region& source = builder.Source();
+    const Coefficients coefficients = MatrixCoefficients(options.matrix);
+
+    // planes are read one after another, so the stream is only seeked forward
+    std::vector<uint8_t> row;
+    std::vector<uint8_t> luma(source.height * source.width);
+
+    for (int64_t y = source.top; y != source.top + source.height; ++y) {
+        if (builder.IsRowNeeded(y)) {
+            ReadBytes(f, y * layout.width + source.left, source.width, row);
+            std::copy(row.begin(), row.end(), luma.begin() + (y - source.top) * source.width);
+        }
+    }
+
+    // chroma columns and rows of the source, every chroma sample is shared by a 2 x 2 block of pixels
+    const int64_t first_chroma_column = source.left / 2;
+    const int64_t chroma_columns = (source.left + source.width - 1) / 2 - first_chroma_column + 1;
+    const int64_t first_chroma_row = source.top / 2;
+    const int64_t chroma_rows = (source.top + source.height - 1) / 2 - first_chroma_row + 1;
+
+    std::vector<uint8_t> u(chroma_rows * chroma_columns);
+    std::vector<uint8_t> v(chroma_rows * chroma_columns);
+
+    // I420 keeps U and V in two planes, NV12 in one plane with interleaved samples
+    const int64_t chroma_planes = options.luma_only ? 0 : layout.interleaved ? 1 : 2;
+
+    for (int64_t plane = 0; plane != chroma_planes; ++plane) {
+        for (int64_t i = 0; i != chroma_rows; ++i) {
+            const int64_t chroma_row = first_chroma_row + i;
+            if (!builder.IsRowNeeded(2 * chroma_row) && !builder.IsRowNeeded(2 * chroma_row + 1)) {
+                continue;
+            }
+
+            const std::streamoff offset = plane == 0 ? layout.UOffset(chroma_row) : layout.VOffset(chroma_row);
+            ReadBytes(f, offset + first_chroma_column * layout.ChromaStep(), chroma_columns * layout.ChromaStep(), row);
+
+            for (int64_t j = 0; j != chroma_columns; ++j) {
+                if (layout.interleaved) {
+                    u[i * chroma_columns + j] = row[2 * j];
+                    v[i * chroma_columns + j] = row[2 * j + 1];
+                } else {
+                    (plane == 0 ? u : v)[i * chroma_columns + j] = row[j];
+                }
+            }
+        }
+    }
+
+    std::vector<double> rgb(3 * source.width);
+
+    for (int64_t y = source.top; y != source.top + source.height; ++y) {
+        if (!builder.IsRowNeeded(y)) {
+            continue;
+        }
+
+        const uint8_t* luma_row = &luma[(y - source.top) * source.width];
+        const int64_t chroma_row = (y / 2 - first_chroma_row) * chroma_columns;
+
+        for (int64_t x = 0; x != source.width; ++x) {
+            const double luma_level = std::clamp((luma_row[x] - BLACK_LEVEL) / LUMA_RANGE, 0., 1.);
+
+            if (options.luma_only) {
+                rgb[3 * x] = rgb[3 * x + 1] = rgb[3 * x + 2] = luma_level;
+                continue;
+            }
+
+            const int64_t i = chroma_row + (source.left + x) / 2 - first_chroma_column;
+            const double blue_difference = (u[i] - CHROMA_ZERO) / CHROMA_RANGE;
+            const double red_difference = (v[i] - CHROMA_ZERO) / CHROMA_RANGE;
+
+            rgb[3 * x] = std::clamp(luma_level + coefficients.red_v * red_difference, 0., 1.);
+            rgb[3 * x + 1] = std::clamp(
+                luma_level + coefficients.green_u * blue_difference + coefficients.green_v * red_difference, 0., 1.);
+            rgb[3 * x + 2] = std::clamp(luma_level + coefficients.blue_u * blue_difference, 0., 1.);
+        }
+
+        builder.AddRow(y, rgb.data(), 1.0);
+    }
+
+    img = builder.Release();
+
+    if (options.luma_only) {
+        img->SetColorMode(ColorMode::grayscale);
+    }
+
+    return img;
+}
+
+void yuv_reader::SaveFile(const std::string& output_path, Image* img, const WriteOptions& options) {
+    std::fstream f;
+    f.open(output_path, std::ios::out | std::ios::binary);
+
+    if (!f.is_open()) {
+        throw FileCreationError{};
+    }
+
+    SaveStream(f, img, options, std::filesystem::path(output_path).extension().string());
+    f.close();
+}
+
+void yuv_reader::SaveStream(std::ostream& f, Image* img, const WriteOptions& options, const std::string& extension) {
+    auto [height, width] = img->Shape();
+    const Layout layout = MakeLayout(extension, width, height);
+    const Coefficients coefficients = MatrixCoefficients(YuvMatrix::bt601);
+
+    // chroma of a 2 x 2 block is the average of the chroma of its pixels
+    std::vector<uint8_t> frame(layout.FrameSize());
+    std::vector<double> blue_differences(layout.chroma_width * layout.chroma_height);
+    std::vector<double> red_differences(layout.chroma_width * layout.chroma_height);
+    std::vector<int64_t> block_sizes(layout.chroma_width * layout.chroma_height);
+
+    for (int64_t y = 0; y != height; ++y) {
+        for (int64_t x = 0; x != width; ++x) {
+            const Pixel& pixel = img->Get(y, x);
+            const double luma_level =
+                coefficients.red * pixel.r + coefficients.green * pixel.g + coefficients.blue * pixel.b;
+            const int64_t i = y / 2 * layout.chroma_width + x / 2;
+
+            frame[y * width + x] = Quantize(BLACK_LEVEL + LUMA_RANGE * luma_level);
+            blue_differences[i] += (pixel.b - luma_level) / coefficients.blue_u;
+            red_differences[i] += (pixel.r - luma_level) / coefficients.red_v;
+            ++block_sizes[i];
+        }
+    }
+
+    for (int64_t row = 0; row != layout.chroma_height; ++row) {
+        for (int64_t column = 0; column != layout.chroma_width; ++column) {
+            const int64_t i = row * layout.chroma_width + column;
+            const auto block_size = static_cast<double>(block_sizes[i]);
+
+            frame[layout.UOffset(row) + column * layout.ChromaStep()] =
+                Quantize(CHROMA_ZERO + CHROMA_RANGE * blue_differences[i] / block_size);
+            frame[layout.VOffset(row) + column * layout.ChromaStep()] =
+                Quantize(CHROMA_ZERO + CHROMA_RANGE * red_differences[i] / block_size);
+        }
+    }
+
+    f.write(reinterpret_cast<char*>(frame.data()), static_cast<std::streamsize>(frame.size()));
+}
@@ -48,6 +48,101 @@ TEST_CASE("bmp_reader::ReadFile test") {  // NOLINT
     REQUIRE(Pixel(233. / 255., 139. / 255., 109. / 255.) == test->Get(200, 200));  // NOLINT
 }
 
+TEST_CASE("bmp_reader::ReadHeader test") {
+    std::filesystem::path test_path = "../tasks/image_processor/test_script/data";
+
+    REQUIRE_THROWS(bmp_reader::ReadHeader(""), FileNotFoundError{});
+    REQUIRE_THROWS(bmp_reader::ReadHeader(test_path / "cat-sus.png"), UnsupportedFileFormat{test_path / "cat-sus.png"});
+
+    bmp_reader::Header header = bmp_reader::ReadHeader(test_path / "flag.bmp");
+
+    REQUIRE(10 == header.width);           // NOLINT
+    REQUIRE(20 == header.height);          // NOLINT
+    REQUIRE(24 == header.bits_per_pixel);  // NOLINT
+    REQUIRE(640 == header.bitmap_size);    // NOLINT
+}
+
+TEST_CASE("bmp_reader::ReadFile top-down 32 bits test") {
+    Image* test = nullptr;
+    Image* correct = nullptr;
+    std::filesystem::path test_path = "../tasks/image_processor/test_script/data";
+
+    bmp_reader::Header header = bmp_reader::ReadHeader(test_path / "flag_bgra.bmp");
+
+    REQUIRE(header.top_down);
+    REQUIRE(32 == header.bits_per_pixel);  // NOLINT
+    REQUIRE(20 == header.height);          // NOLINT
+
+    // BITMAPV5HEADER, negative height and BGRA pixels
+    test = bmp_reader::ReadFile(test_path / "flag_bgra.bmp", test);
+    correct = bmp_reader::ReadFile(test_path / "flag.bmp", correct);
+
+    REQUIRE(correct->Shape() == test->Shape());
+    REQUIRE(Pixel(0., 0., 187. / 255.) == test->Get(0, 0));  // NOLINT
+    REQUIRE(correct->Get(19, 9) == test->Get(19, 9));        // NOLINT
+    REQUIRE(correct->Get(4, 4) == test->Get(4, 4));          // NOLINT
+
+    delete test;
+    delete correct;
+}
+
+TEST_CASE("bmp_reader::ReadFile crop window test") {
+    Image* full = nullptr;
+    Image* test = nullptr;
+    std::filesystem::path test_path = "../tasks/image_processor/test_script/data";
+
+    full = bmp_reader::ReadFile(test_path / "flag.bmp", full);
+    test = bmp_reader::ReadFile(test_path / "flag.bmp", test, {Region{2, 3, 5, 4}});  // NOLINT
+
+    REQUIRE(std::make_tuple(5, 4) == test->Shape());  // NOLINT
+    for (int64_t i = 0; i != 5; ++i) {                // NOLINT
+        for (int64_t j = 0; j != 4; ++j) {            // NOLINT
+            REQUIRE(full->Get(i + 2, j + 3) == test->Get(i, j));
+        }
+    }
+
+    delete test;
+
+    // window is clipped by the image borders
+    test = bmp_reader::ReadFile(test_path / "flag.bmp", test, {Region{0, 0, 100, 7}});  // NOLINT
+
+    REQUIRE(std::make_tuple(20, 7) == test->Shape());  // NOLINT
+    REQUIRE(full->Get(19, 6) == test->Get(19, 6));     // NOLINT
+
+    delete test;
+    delete full;
+}
+
+TEST_CASE("bmp_reader::ReadFile scale test") {
+    Image* full = nullptr;
+    Image* test = nullptr;
+    std::filesystem::path test_path = "../tasks/image_processor/test_script/data";
+
+    full = bmp_reader::ReadFile(test_path / "flag.bmp", full);
+    test = bmp_reader::ReadFile(test_path / "flag.bmp", test, {std::nullopt, 4});  // NOLINT
+
+    REQUIRE(std::make_tuple(5, 3) == test->Shape());  // NOLINT
+
+    // last column block is only 2 pixels wide
+    Pixel sum;
+    for (int64_t i = 0; i != 4; ++i) {                              // NOLINT
+        sum += full->Get(i, 8) * 0.125 + full->Get(i, 9) * 0.125;  // NOLINT
+    }
+    REQUIRE(sum == test->Get(0, 2));
+
+    delete test;
+
+    // stride reads use only the first row of every block
+    test = bmp_reader::ReadFile(test_path / "flag.bmp", test,
+                                {Region{1, 0, 1, 1}, 2, ScaleMethod::stride});  // NOLINT
+
+    REQUIRE(std::make_tuple(1, 1) == test->Shape());                            // NOLINT
+    REQUIRE(full->Get(2, 0) * 0.5 + full->Get(2, 1) * 0.5 == test->Get(0, 0));  // NOLINT
+
+    delete test;
+    delete full;
+}
+
 TEST_CASE("bmp_reader::WriteFile test") {
     std::filesystem::path test_path = "../tasks/image_processor/test_script/data";
     Image* test = new Image{5, 5, 100, 456};  // NOLINT
@@ -76,4 +171,100 @@ TEST_CASE("bmp_reader::WriteFile test") {
     REQUIRE(Pixel(0., 0.5, 0.5) == test->Get(3, 1));           // NOLINT
 
     delete test;
-}
\ No newline at end of file
+}
+
+TEST_CASE("bmp_reader::WriteFile grayscale test") {
+    std::filesystem::path test_path = "../tasks/image_processor/test_script/data";
+    Image* test = new Image{2, 3, 100, 100};  // NOLINT
+
+    std::vector<std::vector<Pixel>> bitmap{{Pixel(1., 1., 1.), Pixel(0.5, 0.5, 0.5), Pixel(0., 0., 0.)},    // NOLINT
+                                           {Pixel(0.2, 0.2, 0.2), Pixel(0.7, 0.7, 0.7), Pixel(1., 1., 1.)}};  // NOLINT
+    test->GetPixels() = std::move(bitmap);
+
+    // grayscale image is detected and saved with 8 bits per pixel
+    bmp_reader::SaveFile(test_path / "test.bmp", test, {ColorDepth::automatic});
+    delete test;
+
+    bmp_reader::Header header = bmp_reader::ReadHeader(test_path / "test.bmp");
+
+    REQUIRE(8 == header.bits_per_pixel);    // NOLINT
+    REQUIRE(256 == header.palette.size());  // NOLINT
+
+    test = bmp_reader::ReadFile(test_path / "test.bmp", test);
+
+    REQUIRE(std::make_tuple(2, 3) == test->Shape());  // NOLINT
+    REQUIRE(ColorMode::grayscale == test->GetColorMode());
+    REQUIRE(Pixel(0.5, 0.5, 0.5) == test->Get(0, 1));  // NOLINT
+    REQUIRE(Pixel(0.7, 0.7, 0.7) == test->Get(1, 1));  // NOLINT
+
+    delete test;
+}
+
+TEST_CASE("bmp_reader::WriteFile monochrome test") {
+    std::filesystem::path test_path = "../tasks/image_processor/test_script/data";
+    Image* test = new Image{3, 11, 100, 100};  // NOLINT
+
+    for (int64_t i = 0; i != 3; ++i) {       // NOLINT
+        for (int64_t j = 0; j != 11; ++j) {  // NOLINT
+            test->Get(i, j) = (i + j) % 3 == 0 ? Pixel(1., 1., 1.) : Pixel(0., 0., 0.);
+        }
+    }
+    test->SetColorMode(ColorMode::monochrome);
+
+    // monochrome image is saved as a bitmask
+    bmp_reader::SaveFile(test_path / "test.bmp", test, {ColorDepth::automatic});
+
+    bmp_reader::Header header = bmp_reader::ReadHeader(test_path / "test.bmp");
+
+    REQUIRE(1 == header.bits_per_pixel);  // NOLINT
+    REQUIRE(12 == header.bitmap_size);    // NOLINT
+    REQUIRE(2 == header.palette.size());  // NOLINT
+
+    // window starting in the middle of a byte
+    Image* read = nullptr;
+    read = bmp_reader::ReadFile(test_path / "test.bmp", read, {Region{1, 3, 2, 8}});  // NOLINT
+
+    REQUIRE(std::make_tuple(2, 8) == read->Shape());  // NOLINT
+    REQUIRE(ColorMode::monochrome == read->GetColorMode());
+    for (int64_t i = 0; i != 2; ++i) {      // NOLINT
+        for (int64_t j = 0; j != 8; ++j) {  // NOLINT
+            REQUIRE(test->Get(i + 1, j + 3) == read->Get(i, j));
+        }
+    }
+
+    delete read;
+    delete test;
+}
+
+TEST_CASE("bmp_reader::ReadFile scaled monochrome test") {
+    std::filesystem::path test_path = "../tasks/image_processor/test_script/data";
+    Image* test = new Image{4, 4, 100, 100};  // NOLINT
+
+    for (int64_t i = 0; i != 4; ++i) {      // NOLINT
+        for (int64_t j = 0; j != 4; ++j) {  // NOLINT
+            test->Get(i, j) = (i + j) % 4 == 0 ? Pixel(1., 1., 1.) : Pixel(0., 0., 0.);
+        }
+    }
+    test->SetColorMode(ColorMode::monochrome);
+    bmp_reader::SaveFile(test_path / "test.bmp", test, {ColorDepth::automatic});
+
+    // averaged blocks have gray levels, so they are not thresholded back to black and white
+    Image* read = nullptr;
+    read = bmp_reader::ReadFile(test_path / "test.bmp", read, {std::nullopt, 2});
+
+    REQUIRE(ColorMode::grayscale == read->GetColorMode());
+    REQUIRE(Pixel(0.25, 0.25, 0.25) == read->Get(0, 0));  // NOLINT
+    REQUIRE(ColorDepth::grayscale == DetectColorDepth(*read));
+
+    delete read;
+
+    // stride reads skip rows, but the columns of the first row of a block are still averaged
+    read = bmp_reader::ReadFile(test_path / "test.bmp", read, {std::nullopt, 2, ScaleMethod::stride});
+
+    REQUIRE(ColorMode::grayscale == read->GetColorMode());
+    REQUIRE(Pixel(0.5, 0.5, 0.5) == read->Get(0, 0));  // NOLINT
+    REQUIRE(ColorDepth::grayscale == DetectColorDepth(*read));
+
+    delete read;
+    delete test;
+}
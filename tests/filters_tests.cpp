@@ -4,6 +4,7 @@
 
 #include "utils/exceptions.h"
 #include "utils/filters.h"
+#include "utils/static_pipeline.h"
 #include "utils/bmp_reader.h"
 #include "utils/console_interface.h"
 
@@ -23,6 +24,21 @@ bool ComparePixelwise(const Image& img1, const Image& img2) {
 
     return true;
 }
+
+// fused filters must give the same doubles, not only the same 8-bit colors
+bool CompareExactly(const Image& img1, const Image& img2) {
+    auto [height, width] = img1.Shape();
+
+    for (int64_t i = 0; i < height; ++i) {
+        for (int64_t j = 0; j < width; ++j) {
+            if (img1.Get(i, j).Tuple() != img2.Get(i, j).Tuple()) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
 }  // namespace
 
 TEST_CASE("Crop filter test") {
@@ -94,6 +110,7 @@ TEST_CASE("Grayscale filter test") {
     Image* correct = nullptr;
     correct = bmp_reader::ReadFile(TEST_PATH / "lenna_gs.bmp", correct);
 
+    REQUIRE(ColorMode::grayscale == img->GetColorMode());
     REQUIRE(correct->Shape() == img->Shape());
     REQUIRE(ComparePixelwise(*img, *correct));
 
@@ -202,6 +219,7 @@ TEST_CASE("Edge detection filter test") {
     Image* correct = nullptr;
     correct = bmp_reader::ReadFile(TEST_PATH / "flag_edge.bmp", correct);
 
+    REQUIRE(ColorMode::monochrome == img->GetColorMode());
     REQUIRE(correct->Shape() == img->Shape());
     REQUIRE(ComparePixelwise(*img, *correct));
 
@@ -249,4 +267,226 @@ TEST_CASE("Gaussian blur filter test") {
     delete img;
     delete correct;
     delete filter_to_check;
-}
\ No newline at end of file
+}
+TEST_CASE("Point filter test") {
+    Image* img = nullptr;
+    img = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", img);
+
+    Image* correct = nullptr;
+    correct = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", correct);
+
+    // one pass gives exactly the result of the filters applied one by one
+    PointFilter().Apply(*img, {{PointFilter::Operation::negative, PointFilter::Operation::grayscale,
+                                PointFilter::Operation::negative}});
+    NegativeFilter().Apply(*correct, NegativeFilter::Parameters{});
+    GrayscaleFilter().Apply(*correct, GrayscaleFilter::Parameters{});
+    NegativeFilter().Apply(*correct, NegativeFilter::Parameters{});
+
+    REQUIRE(correct->Shape() == img->Shape());
+    REQUIRE(CompareExactly(*img, *correct));
+
+    REQUIRE(ColorMode::grayscale == img->GetColorMode());
+
+    delete img;
+    delete correct;
+}
+
+TEST_CASE("Tiled filter test") {
+    Image* img = nullptr;
+    img = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", img);
+    img->Reshape(300, 300);  // NOLINT
+
+    Image* correct = nullptr;
+    correct = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", correct);
+    correct->Reshape(300, 300);  // NOLINT
+
+    // tiles of the chain give exactly the result of the filters applied to the whole image
+    const GaussianBlurFilter::Parameters blur{2};
+    const EdgeDetectionFilter::Parameters edge{0.1};  // NOLINT
+    const TiledFilter::Parameters chain{
+        {[&blur](Image& tile) { GaussianBlurFilter().Apply(tile, blur); },
+         [](Image& tile) { SharpeningFilter().Apply(tile, SharpeningFilter::Parameters{}); },
+         [&edge](Image& tile) { EdgeDetectionFilter().Apply(tile, edge); }},
+        GaussianBlurFilter::Radius(blur) + SharpeningFilter::Radius({}) + EdgeDetectionFilter::Radius(edge)};
+
+    TiledFilter().Apply(*img, chain);
+    GaussianBlurFilter().Apply(*correct, blur);
+    SharpeningFilter().Apply(*correct, SharpeningFilter::Parameters{});
+    EdgeDetectionFilter().Apply(*correct, edge);
+
+    REQUIRE(correct->Shape() == img->Shape());
+    REQUIRE(CompareExactly(*img, *correct));
+
+    REQUIRE(ColorMode::monochrome == img->GetColorMode());
+
+    delete img;
+    delete correct;
+}
+
+TEST_CASE("Static pipeline test") {
+    Image* img = nullptr;
+    img = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", img);
+
+    Image* correct = nullptr;
+    correct = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", correct);
+
+    // the fused chain gives exactly the result of the filters applied one by one
+    using namespace static_pipeline;  // NOLINT
+    Pipeline<Grayscale, Negative, Sharpen>().Apply(*img);
+    GrayscaleFilter().Apply(*correct, GrayscaleFilter::Parameters{});
+    NegativeFilter().Apply(*correct, NegativeFilter::Parameters{});
+    SharpeningFilter().Apply(*correct, SharpeningFilter::Parameters{});
+
+    REQUIRE(correct->Shape() == img->Shape());
+    REQUIRE(CompareExactly(*img, *correct));
+    REQUIRE(ColorMode::grayscale == img->GetColorMode());
+
+    // point filters before the first stencil, between stencils and after the last one
+    Pipeline<Negative, Blur, Sharpen, Negative, EdgeDetection, Negative>(Negative{}, Blur{1.5}, Sharpen{}, Negative{},
+                                                                         EdgeDetection{0.1}, Negative{})  // NOLINT
+        .Apply(*img);
+    NegativeFilter().Apply(*correct, NegativeFilter::Parameters{});
+    GaussianBlurFilter().Apply(*correct, GaussianBlurFilter::Parameters{1.5});  // NOLINT
+    SharpeningFilter().Apply(*correct, SharpeningFilter::Parameters{});
+    NegativeFilter().Apply(*correct, NegativeFilter::Parameters{});
+    EdgeDetectionFilter().Apply(*correct, EdgeDetectionFilter::Parameters{0.1});  // NOLINT
+    NegativeFilter().Apply(*correct, NegativeFilter::Parameters{});
+
+    REQUIRE(CompareExactly(*img, *correct));
+    REQUIRE(ColorMode::monochrome == img->GetColorMode());
+
+    delete img;
+    delete correct;
+}
+
+TEST_CASE("Region filter test") {
+    Image* img = nullptr;
+    img = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", img);
+
+    Image* correct = nullptr;
+    correct = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", correct);
+    const Image original = *img;
+
+    // inside the region the pixels are exactly the pixels of the whole filtered image
+    const GaussianBlurFilter::Parameters blur{1};
+    RegionFilter::Parameters region = RegionFilter::ParseParameters(std::queue<std::string>({"2", "1", "5", "3"}));
+    region.filter = [&blur](Image& part) { GaussianBlurFilter().Apply(part, blur); };
+    region.halo = GaussianBlurFilter::Radius(blur);
+
+    RegionFilter().Apply(*img, region);
+    GaussianBlurFilter().Apply(*correct, blur);
+
+    auto [height, width] = img->Shape();
+    for (int64_t i = 0; i != height; ++i) {
+        for (int64_t j = 0; j != width; ++j) {
+            const bool inside = i >= 1 && i < 4 && j >= 2 && j < 7;  // NOLINT
+            REQUIRE((inside ? *correct : original).Get(i, j).Tuple() == img->Get(i, j).Tuple());
+        }
+    }
+
+    // a black and white region of a color image keeps the image in color
+    region.filter = [](Image& part) { EdgeDetectionFilter().Apply(part, EdgeDetectionFilter::Parameters{0.1}); };
+    RegionFilter().Apply(*img, region);
+    REQUIRE(ColorMode::rgb == img->GetColorMode());
+
+    REQUIRE_THROWS_AS(RegionFilter::ParseParameters(std::queue<std::string>({"1", "2", "3"})),
+                      InvalidFilterParametersError);
+    REQUIRE_THROWS_AS(RegionFilter::ParseParameters(std::queue<std::string>({"1", "-2", "3", "4"})),
+                      InvalidFilterParametersError);
+
+    delete img;
+    delete correct;
+}
+
+TEST_CASE("Masked filter test") {
+    Image* img = nullptr;
+    img = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", img);
+    const Image original = *img;
+
+    Image* correct = nullptr;
+    correct = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", correct);
+    NegativeFilter().Apply(*correct, NegativeFilter::Parameters{});
+
+    // white pixels select the filtered image, gray ones mix it with the original, the rest is not covered
+    auto [height, width] = img->Shape();
+    auto mask = std::make_shared<Image>(height - 1, width, 0, 0);
+    mask->Get(0, 0) = Pixel(1., 1., 1.);
+    mask->Get(1, 2) = Pixel(0.5, 0.5, 0.5);  // NOLINT
+    mask->SetColorMode(ColorMode::grayscale);
+
+    MaskedFilter::Parameters masked{
+        "", mask, [](Image& part) { NegativeFilter().Apply(part, NegativeFilter::Parameters{}); }, 0};
+    MaskedFilter().Apply(*img, masked);
+
+    for (int64_t i = 0; i != height; ++i) {
+        for (int64_t j = 0; j != width; ++j) {
+            const double weight = i + 1 < height ? mask->Get(i, j).r : 0;
+            const Pixel expected(original.Get(i, j).r * (1 - weight) + correct->Get(i, j).r * weight,
+                                 original.Get(i, j).g * (1 - weight) + correct->Get(i, j).g * weight,
+                                 original.Get(i, j).b * (1 - weight) + correct->Get(i, j).b * weight);
+            REQUIRE(expected.Tuple() == img->Get(i, j).Tuple());
+        }
+    }
+
+    // a mask selecting the whole image gives the filtered image
+    Image* whole = nullptr;
+    whole = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", whole);
+    Image* blurred = nullptr;
+    blurred = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", blurred);
+    const GaussianBlurFilter::Parameters blur{1};
+    GaussianBlurFilter().Apply(*blurred, blur);
+
+    auto white = std::make_shared<Image>(height, width, 0, 0);
+    for (int64_t i = 0; i != height; ++i) {
+        for (int64_t j = 0; j != width; ++j) {
+            white->Get(i, j) = Pixel(1., 1., 1.);
+        }
+    }
+
+    masked = {"", white, [&blur](Image& part) { GaussianBlurFilter().Apply(part, blur); },
+              GaussianBlurFilter::Radius(blur)};
+    MaskedFilter().Apply(*whole, masked);
+    REQUIRE(CompareExactly(*blurred, *whole));
+
+    REQUIRE_THROWS_AS(MaskedFilter::ParseParameters(std::queue<std::string>({"a.bmp", "b.bmp"})),
+                      InvalidFilterParametersError);
+
+    delete img;
+    delete correct;
+    delete whole;
+    delete blurred;
+}
+
+TEST_CASE("Combining filters test") {
+    Image* img = nullptr;
+    img = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", img);
+
+    Image* other = nullptr;
+    other = bmp_reader::ReadFile(TEST_PATH / "flag.bmp", other);
+    NegativeFilter().Apply(*other, NegativeFilter::Parameters{});
+
+    Image mask(1, 1, 0, 0);  // NOLINT
+    mask.Get(0, 0) = Pixel(1., 1., 1.);
+    mask.SetColorMode(ColorMode::monochrome);
+
+    // the result keeps the part covered by all inputs
+    Image masked = *img;
+    MaskFilter().Apply(masked, {other, &mask}, MaskFilter::Parameters{});
+    REQUIRE(std::make_tuple(1, 1) == masked.Shape());
+    REQUIRE(img->Get(0, 0).Tuple() == masked.Get(0, 0).Tuple());
+
+    Image difference = *img;
+    DifferenceFilter().Apply(difference, {img}, DifferenceFilter::Parameters{});
+    REQUIRE(difference.Shape() == img->Shape());
+    REQUIRE(std::make_tuple(0., 0., 0.) == difference.Get(3, 4).Tuple());
+
+    // an image blended with its negative by halves is gray
+    BlendFilter().Apply(*img, {other}, BlendFilter::Parameters{0.5});  // NOLINT
+    REQUIRE(ComparePixelwise(*img, Image(std::vector<std::vector<Pixel>>(
+                                       std::get<0>(img->Shape()),
+                                       std::vector<Pixel>(std::get<1>(img->Shape()), Pixel(0.5, 0.5, 0.5))))));  // NOLINT
+    REQUIRE(ColorMode::rgb == img->GetColorMode());
+
+    delete img;
+    delete other;
+}
@@ -0,0 +1,358 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+#include "utils/bmp_reader.h"
+#include "utils/image_io.h"
+#include "utils/ipt_reader.h"
+#include "utils/pfm_reader.h"
+#include "utils/pnm_reader.h"
+#include "utils/qoi_reader.h"
+#include "utils/tiff_reader.h"
+
+namespace {
+const std::filesystem::path TEST_PATH = "../tasks/image_processor/test_script/data";
+
+bool ComparePixelwise(const Image& img1, const Image& img2) {
+    auto [height, width] = img1.Shape();
+
+    for (int64_t i = 0; i < height; ++i) {
+        for (int64_t j = 0; j < width; ++j) {
+            if (img1.Get(i, j) != img2.Get(i, j)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+}  // namespace
+
+TEST_CASE("image_io::IsSupported test") {
+    REQUIRE(image_io::IsSupported("image.bmp"));
+    REQUIRE(image_io::IsSupported("/tmp/image.qoi"));
+    REQUIRE(image_io::IsSupported("image.tiff"));
+    REQUIRE_FALSE(image_io::IsSupported("image.png"));
+    REQUIRE_FALSE(image_io::IsSupported("bmp"));
+    REQUIRE(image_io::IsSupported(image_io::STANDARD_STREAM));
+    REQUIRE(image_io::IsFormatSupported(".nv12"));
+    REQUIRE_FALSE(image_io::IsFormatSupported("nv12"));
+
+    Image* test = nullptr;
+    REQUIRE_THROWS(image_io::ReadFile(TEST_PATH / "cat-sus.png", test), UnsupportedFileFormat{"cat-sus.png"});
+}
+
+TEST_CASE("QOI codec test") {
+    Image* correct = nullptr;
+    Image* test = nullptr;
+
+    correct = image_io::ReadFile(TEST_PATH / "flag.bmp", correct);
+    image_io::SaveFile(TEST_PATH / "test.qoi", correct);
+
+    REQUIRE_THROWS_AS(image_io::ReadFile(TEST_PATH / "flag.qoi", test), FileNotFoundError);
+
+    // wrong magic bytes
+    std::istringstream wrong_magic(std::string("qoiX\x00\x00\x00\x01\x00\x00\x00\x01\x03\x00", 14));  // NOLINT
+    REQUIRE_THROWS_AS(qoi_reader::ReadStream(wrong_magic, nullptr), UnsupportedFileFormat);
+
+    test = image_io::ReadFile(TEST_PATH / "test.qoi", test);
+
+    REQUIRE(correct->Shape() == test->Shape());
+    REQUIRE(ComparePixelwise(*correct, *test));
+
+    delete test;
+
+    // window and scale are applied while decoding
+    test = image_io::ReadFile(TEST_PATH / "test.qoi", test, {Region{3, 2, 4, 5}});  // NOLINT
+
+    REQUIRE(std::make_tuple(4, 5) == test->Shape());  // NOLINT
+    REQUIRE(correct->Get(6, 6) == test->Get(3, 4));   // NOLINT
+
+    delete test;
+
+    test = image_io::ReadFile(TEST_PATH / "test.qoi", test, {std::nullopt, 2});
+
+    REQUIRE(std::make_tuple(10, 5) == test->Shape());  // NOLINT
+
+    // sizes from the header are checked before anything is allocated
+    std::istringstream huge(std::string("qoif\xff\xff\xff\xff\xff\xff\xff\xff\x03\x00", 14));  // NOLINT
+    REQUIRE_THROWS_AS(qoi_reader::ReadStream(huge, nullptr), ImageTooLargeError);
+    std::istringstream empty(std::string("qoif\x00\x00\x00\x00\x00\x00\x00\x05\x03\x00", 14));  // NOLINT
+    REQUIRE_THROWS_AS(qoi_reader::ReadStream(empty, nullptr), UnsupportedFileFormat);
+
+    std::filesystem::remove(TEST_PATH / "test.qoi");
+
+    delete test;
+    delete correct;
+}
+
+TEST_CASE("Netpbm codec test") {
+    Image* correct = nullptr;
+    Image* test = nullptr;
+
+    correct = image_io::ReadFile(TEST_PATH / "flag.bmp", correct);
+
+    // 8 and 16 bits samples
+    for (uint8_t sample_bits : {8, 16}) {  // NOLINT
+        for (const std::string extension : {".ppm", ".pam"}) {
+            image_io::SaveFile(TEST_PATH / ("test" + extension), correct, {ColorDepth::rgb, sample_bits});
+            test = image_io::ReadFile(TEST_PATH / ("test" + extension), test);
+
+            REQUIRE(correct->Shape() == test->Shape());
+            REQUIRE(ComparePixelwise(*correct, *test));
+
+            delete test;
+            std::filesystem::remove(TEST_PATH / ("test" + extension));
+        }
+    }
+
+    // PGM is read as a grayscale image
+    image_io::SaveFile(TEST_PATH / "test.pgm", correct);
+    test = image_io::ReadFile(TEST_PATH / "test.pgm", test, {Region{0, 0, 3, 3}});
+
+    REQUIRE(std::make_tuple(3, 3) == test->Shape());
+    REQUIRE(ColorMode::grayscale == test->GetColorMode());
+    REQUIRE(test->Get(2, 1).r == test->Get(2, 1).b);
+
+    std::filesystem::remove(TEST_PATH / "test.pgm");
+
+    // sizes from the header are checked before anything is allocated
+    std::istringstream huge("P5 4000000000 4000000000 255\n");
+    REQUIRE_THROWS_AS(pnm_reader::ReadStream(huge, nullptr), ImageTooLargeError);
+    std::istringstream truncated("P5\n60000 60000\n255\n");
+    REQUIRE_THROWS_AS(pnm_reader::ReadStream(truncated, nullptr), UnsupportedFileFormat);
+
+    delete test;
+    delete correct;
+}
+
+TEST_CASE("TIFF codec test") {
+    Image* correct = nullptr;
+    Image* test = nullptr;
+
+    correct = image_io::ReadFile(TEST_PATH / "flag.bmp", correct);
+
+    // strips, tiles and BigTIFF with 8 and 16 bits samples
+    for (uint8_t sample_bits : {8, 16}) {  // NOLINT
+        for (int64_t tile_size : {0, 16}) {  // NOLINT
+            for (const std::string extension : {".tif", ".btf"}) {
+                image_io::SaveFile(TEST_PATH / ("test" + extension), correct,
+                                   {ColorDepth::rgb, sample_bits, tile_size});
+                test = image_io::ReadFile(TEST_PATH / ("test" + extension), test);
+
+                REQUIRE(correct->Shape() == test->Shape());
+                REQUIRE(correct->Resolution() == test->Resolution());
+                REQUIRE(ComparePixelwise(*correct, *test));
+
+                delete test;
+                std::filesystem::remove(TEST_PATH / ("test" + extension));
+            }
+        }
+    }
+
+    // tile size has to be a multiple of 16
+    REQUIRE_THROWS(image_io::SaveFile(TEST_PATH / "test.tif", correct, {ColorDepth::rgb, 8, 10}),  // NOLINT
+                   InvalidArgumentsError{});
+
+    // only the tiles of the window are read
+    image_io::SaveFile(TEST_PATH / "test.tif", correct, {ColorDepth::grayscale, 8, 16});  // NOLINT
+    test = image_io::ReadFile(TEST_PATH / "test.tif", test, {Region{3, 2, 4, 5}});     // NOLINT
+
+    REQUIRE(std::make_tuple(4, 5) == test->Shape());  // NOLINT
+    REQUIRE(ColorMode::grayscale == test->GetColorMode());
+    REQUIRE(test->Get(1, 1).r == test->Get(1, 1).g);
+
+    std::filesystem::remove(TEST_PATH / "test.tif");
+
+    delete test;
+    delete correct;
+}
+
+TEST_CASE("PFM codec test") {
+    Image* correct = nullptr;
+    Image* test = nullptr;
+
+    correct = image_io::ReadFile(TEST_PATH / "flag.bmp", correct);
+    image_io::SaveFile(TEST_PATH / "test.pfm", correct);
+    test = image_io::ReadFile(TEST_PATH / "test.pfm", test);
+
+    REQUIRE(correct->Shape() == test->Shape());
+    REQUIRE(ComparePixelwise(*correct, *test));
+
+    delete test;
+
+    // colors between 8 bits levels are kept
+    correct->GetPixels()[1][2] = Pixel(0.123456, 0.5, 1.0);  // NOLINT
+    image_io::SaveFile(TEST_PATH / "test.pfm", correct);
+    test = image_io::ReadFile(TEST_PATH / "test.pfm", test, {Region{1, 2, 1, 1}});
+
+    REQUIRE(std::make_tuple(1, 1) == test->Shape());
+    REQUIRE(std::abs(test->Get(0, 0).r - 0.123456) < 1e-6);  // NOLINT
+
+    delete test;
+
+    image_io::SaveFile(TEST_PATH / "test.pfm", correct, {ColorDepth::grayscale});
+    test = image_io::ReadFile(TEST_PATH / "test.pfm", test);
+
+    REQUIRE(ColorMode::grayscale == test->GetColorMode());
+
+    std::filesystem::remove(TEST_PATH / "test.pfm");
+
+    // sizes from the header are checked before anything is allocated
+    std::istringstream huge("PF 4000000000 4000000000 -1\n");
+    REQUIRE_THROWS_AS(pfm_reader::ReadStream(huge, nullptr), ImageTooLargeError);
+    std::istringstream truncated("Pf\n60000 60000\n-1.0\n");
+    REQUIRE_THROWS_AS(pfm_reader::ReadStream(truncated, nullptr), UnsupportedFileFormat);
+
+    delete test;
+    delete correct;
+}
+
+TEST_CASE("YUV codec test") {
+    Image* correct = nullptr;
+    Image* test = nullptr;
+
+    correct = image_io::ReadFile(TEST_PATH / "flag.bmp", correct);
+    auto [height, width] = correct->Shape();
+
+    for (const std::string extension : {".yuv", ".nv12"}) {
+        image_io::SaveFile(TEST_PATH / ("test" + extension), correct);
+
+        // frame size has to be given
+        REQUIRE_THROWS(image_io::ReadFile(TEST_PATH / ("test" + extension), test), InvalidArgumentsError{});
+
+        ReadOptions options;
+
+        // the file has to hold the whole frame
+        options.frame_width = 100000;   // NOLINT
+        options.frame_height = 100000;  // NOLINT
+        REQUIRE_THROWS_AS(image_io::ReadFile(TEST_PATH / ("test" + extension), test, options), UnsupportedFileFormat);
+
+        options.frame_width = width;
+        options.frame_height = height;
+        test = image_io::ReadFile(TEST_PATH / ("test" + extension), test, options);
+
+        REQUIRE(correct->Shape() == test->Shape());
+
+        delete test;
+
+        // luma is enough for a grayscale image
+        options.luma_only = true;
+        test = image_io::ReadFile(TEST_PATH / ("test" + extension), test, options);
+
+        REQUIRE(ColorMode::grayscale == test->GetColorMode());
+        for (int64_t i = 0; i != height; ++i) {
+            for (int64_t j = 0; j != width; ++j) {
+                REQUIRE(std::abs(GrayLevel(correct->Get(i, j)) - test->Get(i, j).r) < 1e-2);  // NOLINT
+            }
+        }
+
+        delete test;
+        std::filesystem::remove(TEST_PATH / ("test" + extension));
+    }
+
+    delete correct;
+}
+
+TEST_CASE("IPT codec test") {
+    Image* correct = nullptr;
+    Image* test = nullptr;
+
+    correct = image_io::ReadFile(TEST_PATH / "flag.bmp", correct);
+    correct->GetPixels()[1][2] = Pixel(0.123456, 0.5, 1.0);  // NOLINT
+    correct->SetColorMode(ColorMode::rgb);
+
+    // pixels are stored without any conversion
+    image_io::SaveFile(TEST_PATH / "test.ipt", correct, {ColorDepth::rgb, 8, 16});  // NOLINT
+    test = image_io::ReadFile(TEST_PATH / "test.ipt", test);
+
+    REQUIRE(correct->Shape() == test->Shape());
+    REQUIRE(correct->Resolution() == test->Resolution());
+    REQUIRE(ComparePixelwise(*correct, *test));
+    REQUIRE(test->Get(1, 2).r == correct->Get(1, 2).r);
+
+    delete test;
+
+    // region crossing several tiles
+    test = image_io::ReadFile(TEST_PATH / "test.ipt", test, {Region{14, 1, 4, 8}});  // NOLINT
+
+    REQUIRE(std::make_tuple(4, 8) == test->Shape());  // NOLINT
+    REQUIRE(correct->Get(17, 8) == test->Get(3, 7));  // NOLINT
+
+    delete test;
+    delete correct;
+
+    // uniform tiles are shared
+    correct = new Image(64, 64, 0, 0);  // NOLINT
+    image_io::SaveFile(TEST_PATH / "test.ipt", correct, {ColorDepth::rgb, 8, 16});  // NOLINT
+    REQUIRE(std::filesystem::file_size(TEST_PATH / "test.ipt") < 2 * 16 * 16 * 3 * sizeof(double));  // NOLINT
+
+    test = image_io::ReadFile(TEST_PATH / "test.ipt", test);
+
+    REQUIRE(correct->Shape() == test->Shape());
+    REQUIRE(ComparePixelwise(*correct, *test));
+
+    std::filesystem::remove(TEST_PATH / "test.ipt");
+
+    // a 2 x 2 image with huge tiles, whose size in bytes wraps around
+    std::string header(128, '\0');  // NOLINT
+    const uint32_t byte_order = 0x01020304;  // NOLINT
+    const uint32_t tile_size = 1u << 31;     // NOLINT
+    const int64_t side = 2;
+    std::memcpy(header.data(), "IPTILES", 8);                       // NOLINT
+    std::memcpy(header.data() + 8, &byte_order, sizeof(byte_order));  // NOLINT
+    std::memcpy(header.data() + 12, &tile_size, sizeof(tile_size));   // NOLINT
+    std::memcpy(header.data() + 16, &side, sizeof(side));             // NOLINT
+    std::memcpy(header.data() + 24, &side, sizeof(side));             // NOLINT
+
+    std::istringstream malformed(header);
+    REQUIRE_THROWS_AS(ipt_reader::ReadStream(malformed, nullptr), UnsupportedFileFormat);
+
+    // with a valid tile size the tile does not fit the file
+    const uint32_t small_tile_size = 16;  // NOLINT
+    std::memcpy(header.data() + 12, &small_tile_size, sizeof(small_tile_size));  // NOLINT
+    std::istringstream truncated(header);
+    REQUIRE_THROWS_AS(ipt_reader::ReadStream(truncated, nullptr), UnsupportedFileFormat);
+
+    delete test;
+    delete correct;
+}
+
+TEST_CASE("Stream codecs test") {
+    Image* correct = nullptr;
+    Image* test = nullptr;
+
+    correct = image_io::ReadFile(TEST_PATH / "flag.bmp", correct);
+
+    std::stringstream bmp;
+    bmp_reader::SaveStream(bmp, correct);
+    test = bmp_reader::ReadStream(bmp, test, {Region{3, 2, 4, 5}});  // NOLINT
+
+    REQUIRE(std::make_tuple(4, 5) == test->Shape());  // NOLINT
+    REQUIRE(correct->Get(6, 6) == test->Get(3, 4));   // NOLINT
+
+    delete test;
+
+    // formats with random access are read from memory
+    std::stringstream tiff;
+    tiff_reader::SaveStream(tiff, correct, {ColorDepth::rgb, 8, 16}, ".tif");  // NOLINT
+    test = tiff_reader::ReadStream(tiff, test);
+
+    REQUIRE(correct->Shape() == test->Shape());
+    REQUIRE(ComparePixelwise(*correct, *test));
+
+    delete test;
+
+    std::stringstream ipt;
+    ipt_reader::SaveStream(ipt, correct, {ColorDepth::rgb, 8, 16});  // NOLINT
+    test = ipt_reader::ReadStream(ipt, test);
+
+    REQUIRE(correct->Shape() == test->Shape());
+    REQUIRE(ComparePixelwise(*correct, *test));
+
+    delete test;
+    delete correct;
+}
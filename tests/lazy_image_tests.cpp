@@ -0,0 +1,77 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <filesystem>
+
+#include "utils/image_io.h"
+#include "utils/lazy_image.h"
+
+namespace {
+const std::filesystem::path TEST_PATH = "../tasks/image_processor/test_script/data";
+
+bool CompareExactly(const Image& img1, const Image& img2) {
+    auto [height, width] = img1.Shape();
+
+    for (int64_t i = 0; i < height; ++i) {
+        for (int64_t j = 0; j < width; ++j) {
+            if (img1.Get(i, j).Tuple() != img2.Get(i, j).Tuple()) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+}  // namespace
+
+TEST_CASE("LazyImage test") {
+    Image* correct = nullptr;
+    correct = image_io::ReadFile(TEST_PATH / "flag.bmp", correct);
+
+    // nothing is read until the pixels are needed
+    const LazyImage missing = LazyImage::Read(TEST_PATH / "missing.bmp").Apply(Node<NegativeFilter>{});
+    REQUIRE_THROWS_AS(missing.Materialize(), FileNotFoundError);
+
+    // the final crop limits the part of the file read and blurred, the result is the same
+    const LazyImage source = LazyImage::Read(TEST_PATH / "flag.bmp");
+    const LazyImage blurred = source.Apply(Node<GaussianBlurFilter>{{1}}).Apply(Node<SharpeningFilter>{});
+    const LazyImage cropped = blurred.Apply(Node<CropFilter>{{10, 7}});  // NOLINT
+
+    GaussianBlurFilter().Apply(*correct, GaussianBlurFilter::Parameters{1});
+    SharpeningFilter().Apply(*correct, SharpeningFilter::Parameters{});
+
+    Image* test = blurred.Materialize();
+    REQUIRE(correct->Shape() == test->Shape());
+    REQUIRE(CompareExactly(*correct, *test));
+    delete test;
+
+    CropFilter().Apply(*correct, CropFilter::Parameters{10, 7});  // NOLINT
+
+    test = cropped.Materialize();
+    REQUIRE(std::make_tuple(7, 10) == test->Shape());  // NOLINT
+    REQUIRE(CompareExactly(*correct, *test));
+
+    // images in memory are sources too
+    const LazyImage copy = LazyImage::FromImage(*test).Apply(Node<NegativeFilter>{});
+    NegativeFilter().Apply(*test, NegativeFilter::Parameters{});
+
+    Image* negative = copy.Materialize();
+    REQUIRE(CompareExactly(*test, *negative));
+
+    delete negative;
+
+    // a shared image is copied by every chain and stays the same
+    const std::shared_ptr<const Image> shared(test);
+    Image* first = LazyImage::FromImage(shared).Apply(Node<NegativeFilter>{}).Materialize();
+    Image* second = LazyImage::FromImage(shared).Apply(Node<CropFilter>{{3, 2}}).Materialize();  // NOLINT
+
+    REQUIRE(std::make_tuple(2, 3) == second->Shape());  // NOLINT
+    REQUIRE(CompareExactly(*second, *shared));
+
+    NegativeFilter().Apply(*first, NegativeFilter::Parameters{});
+    REQUIRE(CompareExactly(*shared, *first));
+
+    delete first;
+    delete second;
+    delete correct;
+}
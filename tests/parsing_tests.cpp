@@ -1,8 +1,13 @@
 #define CATCH_CONFIG_MAIN
 #include <catch.hpp>
 
+#include <algorithm>
+#include <sstream>
+
 #include "utils/exceptions.h"
 #include "utils/console_interface.h"
+#include "utils/graph.h"
+#include "utils/pipeline.h"
 
 TEST_CASE("console_interface::ParseArguments test") {  // NOLINT
     char** argv = new char*[8];                        // NOLINT
@@ -50,3 +55,188 @@ TEST_CASE("console_interface::ParseArguments test") {  // NOLINT
     parameters.pop();
     REQUIRE("cringe_param" == parameters.front());
 }
+
+TEST_CASE("pipeline::Parse test") {  // NOLINT
+    const char* job[] = {"image_processor", "-",     "out.qoi", "--scale", "2",  "-crop", "10",    "20",  // NOLINT
+                         "-gs",             "-neg",  "-blur",   "1.5",     "-crop", "5",  "5",     "-edge", "0.3"};
+    char** argv = const_cast<char**>(job);
+
+    const Pipeline pipeline = pipeline::Parse(17, argv);  // NOLINT
+
+    REQUIRE(2 == pipeline.read_options.scale);
+    REQUIRE(pipeline.read_options.window.has_value());
+    REQUIRE(20 == pipeline.read_options.window->height);  // NOLINT
+    REQUIRE(10 == pipeline.read_options.window->width);   // NOLINT
+    REQUIRE(pipeline.read_options.luma_only);
+
+    // the leading crop is read by the decoder, the negative and the blur are processed in tiles
+    REQUIRE(4 == pipeline.filters.size());
+    REQUIRE(std::holds_alternative<Node<GrayscaleFilter>>(pipeline.filters[0]));
+    REQUIRE(6 == std::get<Node<TiledFilter>>(pipeline.filters[1]).parameters.halo);  // NOLINT
+    REQUIRE(5 == std::get<Node<CropFilter>>(pipeline.filters[2]).parameters.width);  // NOLINT
+    REQUIRE(0.3 == std::get<Node<EdgeDetectionFilter>>(pipeline.filters[3]).parameters.threshold);  // NOLINT
+
+    // wrong parameters of the last filter are found before reading
+    job[16] = "2";  // NOLINT
+    REQUIRE_THROWS_AS(pipeline::Parse(17, argv), InvalidFilterParametersError);  // NOLINT
+
+    // options go before the filters
+    job[16] = "0.3";  // NOLINT
+    job[9] = "--depth";  // NOLINT
+    REQUIRE_THROWS_AS(pipeline::Parse(17, argv), InvalidArgumentsError);  // NOLINT
+
+    // point filters are fused into one pass
+    const char* fused_job[] = {"image_processor", "-", "-", "-sharp", "-crop", "10", "10", "-neg", "-gs", "-neg"};
+    const Pipeline fused = pipeline::Parse(10, const_cast<char**>(fused_job));  // NOLINT
+
+    REQUIRE(3 == fused.filters.size());
+    REQUIRE(3 == std::get<Node<PointFilter>>(fused.filters[2]).parameters.operations.size());
+
+    // stencil chains are processed in tiles with the halo of all stencils
+    const char* tiled_job[] = {"image_processor", "-", "-", "-blur", "2", "-neg", "-sharp", "-edge", "0.1"};
+    const Pipeline tiled = pipeline::Parse(9, const_cast<char**>(tiled_job));  // NOLINT
+
+    REQUIRE(1 == tiled.filters.size());
+    REQUIRE(4 == std::get<Node<TiledFilter>>(tiled.filters[0]).parameters.stages.size());
+    REQUIRE(8 == std::get<Node<TiledFilter>>(tiled.filters[0]).parameters.halo);  // NOLINT
+
+    job[2] = "out.png";  // NOLINT
+    REQUIRE_THROWS_AS(pipeline::Parse(4, argv), UnsupportedFileFormat);  // NOLINT
+}
+
+TEST_CASE("pipeline::Restrict test") {  // NOLINT
+    const char* job[] = {"image_processor", "-", "out.bmp", "-neg", "-roi", "10", "20", "30", "40", "-blur", "2"};  // NOLINT
+    const Pipeline pipeline = pipeline::Parse(11, const_cast<char**>(job));  // NOLINT
+
+    // the region scopes only the blur and reads its halo
+    REQUIRE(2 == pipeline.filters.size());
+    const auto& region = std::get<Node<RegionFilter>>(pipeline.filters[1]).parameters;
+    REQUIRE(20 == region.region.top);    // NOLINT
+    REQUIRE(10 == region.region.left);   // NOLINT
+    REQUIRE(40 == region.region.height);  // NOLINT
+    REQUIRE(30 == region.region.width);   // NOLINT
+    REQUIRE(GaussianBlurFilter::Radius({2}) == pipeline::Radius(pipeline.filters[1]));
+
+    REQUIRE_THROWS_AS(pipeline::Restrict(region, Node<CropFilter>{{1, 1}}), InvalidArgumentsError);
+
+    const char* trailing[] = {"image_processor", "-", "out.bmp", "-neg", "-roi", "1", "2", "3", "4"};  // NOLINT
+    REQUIRE_THROWS_AS(pipeline::Parse(9, const_cast<char**>(trailing)), InvalidArgumentsError);  // NOLINT
+}
+
+TEST_CASE("pipeline::Optimize test") {  // NOLINT
+    std::vector<FilterNode> filters{Node<NegativeFilter>{},       Node<GrayscaleFilter>{},
+                                    Node<CropFilter>{{100, 80}},  Node<GrayscaleFilter>{},
+                                    Node<NegativeFilter>{},       Node<NegativeFilter>{},
+                                    Node<CropFilter>{{50, 300}},  Node<SharpeningFilter>{},
+                                    Node<NegativeFilter>{},       Node<CropFilter>{{5, 5}}};  // NOLINT
+
+    const std::vector<std::string> rewrites = pipeline::Optimize(filters);
+
+    // -crop 50 80 -neg -gs -sharp -crop 5 5 -neg, the sharpening keeps the last crop after it
+    REQUIRE(6 == filters.size());
+    REQUIRE(50 == std::get<Node<CropFilter>>(filters[0]).parameters.width);   // NOLINT
+    REQUIRE(80 == std::get<Node<CropFilter>>(filters[0]).parameters.height);  // NOLINT
+    REQUIRE(std::holds_alternative<Node<NegativeFilter>>(filters[1]));
+    REQUIRE(std::holds_alternative<Node<GrayscaleFilter>>(filters[2]));
+    REQUIRE(std::holds_alternative<Node<SharpeningFilter>>(filters[3]));
+    REQUIRE(std::holds_alternative<Node<CropFilter>>(filters[4]));
+    REQUIRE(std::holds_alternative<Node<NegativeFilter>>(filters[5]));
+
+    REQUIRE(std::find(rewrites.begin(), rewrites.end(), "-neg -neg -> nothing") != rewrites.end());
+    REQUIRE(std::find(rewrites.begin(), rewrites.end(), "-gs -gs -> -gs") != rewrites.end());
+    REQUIRE(std::find(rewrites.begin(), rewrites.end(), "-crop 100 80 -crop 50 300 -> -crop 50 80") !=
+            rewrites.end());
+
+    // nothing to rewrite
+    filters = {Node<EdgeDetectionFilter>{{0.1}}, Node<EdgeDetectionFilter>{{0.5}}};  // NOLINT
+    REQUIRE(pipeline::Optimize(filters).empty());
+    REQUIRE(2 == filters.size());
+}
+
+TEST_CASE("pipeline::ParseOutputs test") {  // NOLINT
+    const char* job[] = {"image_processor", "-",     "--scale", "2",     "-o",   "a.bmp", "-crop", "10", "20",  // NOLINT
+                         "-gs",             "-o",    "-",       "--depth", "8",  "-crop", "30",    "5"};
+    char** argv = const_cast<char**>(job);
+
+    const std::vector<Pipeline> pipelines = pipeline::ParseOutputs(17, argv);  // NOLINT
+
+    // the decoder options are common, the window covers the crops of both outputs, which keep their crops
+    REQUIRE(2 == pipelines.size());
+    REQUIRE("a.bmp" == pipelines[0].output_path);
+    REQUIRE("-" == pipelines[1].output_path);
+    REQUIRE(2 == pipelines[1].read_options.scale);
+    REQUIRE(ColorDepth::grayscale == pipelines[1].write_options.depth);
+    REQUIRE(ColorDepth::rgb == pipelines[0].write_options.depth);
+    REQUIRE(pipelines[0].read_options.window.has_value());
+    REQUIRE(20 == pipelines[0].read_options.window->height);  // NOLINT
+    REQUIRE(30 == pipelines[0].read_options.window->width);   // NOLINT
+    REQUIRE(2 == pipelines[0].filters.size());
+    REQUIRE(1 == pipelines[1].filters.size());
+
+    // decoder options of one output, a missing path and two standard outputs
+    const char* scale[] = {"image_processor", "-", "-o", "a.bmp", "--scale", "2"};  // NOLINT
+    REQUIRE_THROWS_AS(pipeline::ParseOutputs(6, const_cast<char**>(scale)), InvalidArgumentsError);  // NOLINT
+
+    const char* path[] = {"image_processor", "-", "-o", "a.bmp", "-o"};                      // NOLINT
+    REQUIRE_THROWS_AS(pipeline::ParseOutputs(5, const_cast<char**>(path)), InvalidArgumentsError);  // NOLINT
+
+    const char* outputs[] = {"image_processor", "-", "-o", "-", "-neg", "-o", "-"};               // NOLINT
+    REQUIRE_THROWS_AS(pipeline::ParseOutputs(7, const_cast<char**>(outputs)), InvalidArgumentsError);  // NOLINT
+
+    // without -o the command line has one output
+    const char* single[] = {"image_processor", "-", "b.bmp", "-neg"};  // NOLINT
+    REQUIRE(1 == pipeline::ParseOutputs(4, const_cast<char**>(single)).size());  // NOLINT
+}
+
+TEST_CASE("graph::Parse test") {  // NOLINT
+    std::istringstream description(
+        "# shared prefix\n"
+        "photo = ../tasks/image_processor/test_script/data/flag.bmp\n"
+        "\n"
+        "soft = photo -blur 2\n"
+        "edges = photo -blur 2 -edge 0.1\n"
+        "mix = blend soft photo 0.3 -neg\n"
+        "save edges edges.bmp\n"
+        "save mix mix.bmp\n");
+
+    const Graph graph = graph::Parse(description);
+
+    // the blur of edges is the vertex of soft
+    REQUIRE(5 == graph.vertices.size());
+    REQUIRE(std::holds_alternative<SourceNode>(graph.vertices[0].operation));
+    REQUIRE(std::vector<size_t>{0} == graph.vertices[1].inputs);
+    REQUIRE(std::vector<size_t>{1} == graph.vertices[2].inputs);
+    REQUIRE(std::vector<size_t>{1, 0} == graph.vertices[3].inputs);
+    REQUIRE(std::holds_alternative<CombiningNode>(graph.vertices[3].operation));
+    REQUIRE(std::vector<size_t>{3} == graph.vertices[4].inputs);
+    REQUIRE(2 == graph.outputs.size());
+    REQUIRE(std::make_tuple(2ul, std::string("edges.bmp")) == graph.outputs[0]);
+
+    std::istringstream undefined("result = soft -gs\n");
+    REQUIRE_THROWS_AS(graph::Parse(undefined), InvalidGraphError);
+
+    std::istringstream redefined("a = ../tasks/image_processor/test_script/data/flag.bmp\n"
+                                 "a = ../tasks/image_processor/test_script/data/flag.bmp -neg\n");
+    REQUIRE_THROWS_AS(graph::Parse(redefined), InvalidGraphError);
+
+    std::istringstream inputs("# blend needs two inputs\nphoto = ../tasks/image_processor/test_script/data/flag.bmp\n"
+                              "mix = blend photo 0.5\n");
+    REQUIRE_THROWS_AS(graph::Parse(inputs), InvalidGraphError);
+
+    std::istringstream parameters("photo = ../tasks/image_processor/test_script/data/flag.bmp\n"
+                                  "mix = blend photo photo 2\n");
+    REQUIRE_THROWS_AS(graph::Parse(parameters), InvalidFilterParametersError);
+
+    // the mask of -mask is the second input of the filter
+    std::istringstream masked("photo = ../tasks/image_processor/test_script/data/flag.bmp\n"
+                              "edges = photo -edge 0.1\n"
+                              "soft = photo -mask edges -blur 2\n"
+                              "save soft soft.bmp\n");
+    const Graph masked_graph = graph::Parse(masked);
+    REQUIRE(3 == masked_graph.vertices.size());
+    REQUIRE(std::vector<size_t>{0, 1} == masked_graph.vertices[2].inputs);
+
+    std::istringstream unmasked("photo = ../tasks/image_processor/test_script/data/flag.bmp\n"
+                                "soft = photo -mask photo\n");
+    REQUIRE_THROWS_AS(graph::Parse(unmasked), InvalidGraphError);
+}
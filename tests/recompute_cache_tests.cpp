@@ -0,0 +1,95 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <filesystem>
+#include <memory>
+
+#include "utils/image_io.h"
+#include "utils/recompute_cache.h"
+
+namespace {
+const std::filesystem::path TEST_PATH = "../tasks/image_processor/test_script/data";
+
+bool CompareExactly(const Image& img1, const Image& img2) {
+    auto [height, width] = img1.Shape();
+
+    if (img1.Shape() != img2.Shape() || img1.GetColorMode() != img2.GetColorMode()) {
+        return false;
+    }
+
+    for (int64_t i = 0; i < height; ++i) {
+        for (int64_t j = 0; j < width; ++j) {
+            if (img1.Get(i, j).Tuple() != img2.Get(i, j).Tuple()) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// the filters applied one by one without the cache
+std::unique_ptr<Image> Compute(const std::vector<FilterNode>& filters) {
+    Image* img = nullptr;
+    img = image_io::ReadFile(TEST_PATH / "flag.bmp", img);
+
+    for (const FilterNode& filter : filters) {
+        pipeline::Apply(filter, *img);
+    }
+
+    return std::unique_ptr<Image>(img);
+}
+}  // namespace
+
+TEST_CASE("RecomputeCache test") {
+    RecomputeCache cache;
+    const std::string path = TEST_PATH / "flag.bmp";
+
+    std::vector<FilterNode> filters{Node<GaussianBlurFilter>{{1}}, Node<EdgeDetectionFilter>{{0.1}}};  // NOLINT
+    std::unique_ptr<Image> img(cache.Run(path, {}, filters));
+    REQUIRE(2 == cache.LastApplied());
+    REQUIRE(CompareExactly(*Compute(filters), *img));
+
+    // the same chain only compares the stored response with the threshold
+    img.reset(cache.Run(path, {}, filters));
+    REQUIRE(1 == cache.LastApplied());
+    REQUIRE(CompareExactly(*Compute(filters), *img));
+
+    // results of the other filters are taken from the cache
+    img.reset(cache.Run(path, {}, {filters[0]}));
+    REQUIRE(0 == cache.LastApplied());
+    REQUIRE(CompareExactly(*Compute({filters[0]}), *img));
+    img.reset(cache.Run(path, {}, filters));
+    REQUIRE(CompareExactly(*Compute(filters), *img));
+
+    // a new threshold reuses the blur and the stored response
+    filters[1] = Node<EdgeDetectionFilter>{{0.3}};  // NOLINT
+    img.reset(cache.Run(path, {}, filters));
+    REQUIRE(1 == cache.LastApplied());
+    REQUIRE(CompareExactly(*Compute(filters), *img));
+
+    // a new sigma reuses only the source
+    filters[0] = Node<GaussianBlurFilter>{{2}};
+    img.reset(cache.Run(path, {}, filters));
+    REQUIRE(2 == cache.LastApplied());
+    REQUIRE(CompareExactly(*Compute(filters), *img));
+
+    // results after a filter which is not stored are always computed
+    const TiledFilter::Parameters stages{
+        {[](Image& part) { NegativeFilter().Apply(part, NegativeFilter::Parameters{}); }}, 0};
+    const std::vector<FilterNode> tiled{Node<TiledFilter>{stages}, Node<NegativeFilter>{}};
+    img.reset(cache.Run(path, {}, tiled));
+    img.reset(cache.Run(path, {}, tiled));
+    REQUIRE(2 == cache.LastApplied());
+
+    // nothing larger than the capacity is stored
+    RecomputeCache small(1);
+    img.reset(small.Run(path, {}, filters));
+    img.reset(small.Run(path, {}, filters));
+    REQUIRE(2 == small.LastApplied());
+    REQUIRE(0 == small.Size());
+
+    cache.Clear();
+    REQUIRE(0 == cache.Size());
+    REQUIRE_THROWS_AS(cache.Run(TEST_PATH / "missing.bmp", {}, filters), FileNotFoundError);
+}
@@ -0,0 +1,79 @@
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "utils/result_cache.h"
+
+namespace {
+const std::filesystem::path TEST_PATH = "../tasks/image_processor/test_script/data";
+const std::filesystem::path CACHE_PATH = "result_cache_test";
+
+Pipeline Job(std::vector<std::string> arguments) {
+    std::vector<char*> argv{const_cast<char*>("image_processor")};
+    for (std::string& argument : arguments) {
+        argv.push_back(argument.data());
+    }
+
+    return pipeline::Parse(static_cast<int>(argv.size()), argv.data());
+}
+
+std::string ReadBytes(const std::filesystem::path& path) {
+    std::ifstream f(path, std::ios::in | std::ios::binary);
+    return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+}
+}  // namespace
+
+TEST_CASE("ResultCache test") {
+    std::filesystem::remove_all(CACHE_PATH);
+    ResultCache cache(CACHE_PATH);
+
+    const std::string input = TEST_PATH / "flag.bmp";
+    const std::string output = "result_cache_test.bmp";
+    const Pipeline job = Job({input, output, "-gs", "-blur", "1"});
+
+    // equivalent command lines share the output, other parameters and formats do not
+    const std::optional<std::string> key = cache.Key(job);
+    REQUIRE(key.has_value());
+    REQUIRE(key == cache.Key(Job({input, output, "-neg", "-neg", "-gs", "-blur", "1"})));
+    REQUIRE(key == cache.Key(Job({input, "other.bmp", "-gs", "-blur", "1.0"})));
+    REQUIRE(key != cache.Key(Job({input, output, "-gs", "-blur", "2"})));
+    REQUIRE(key != cache.Key(Job({input, "out.qoi", "-gs", "-blur", "1"})));
+    REQUIRE(key != cache.Key(Job({input, output, "--scale", "2", "-gs", "-blur", "1"})));
+    REQUIRE(key != cache.Key(Job({TEST_PATH / "flag_gs.bmp", output, "-gs", "-blur", "1"})));
+
+    // the standard input is never stored
+    REQUIRE_FALSE(cache.Key(Job({"-", output, "-gs"})).has_value());
+    REQUIRE_THROWS_AS(cache.Key(Job({TEST_PATH / "missing.bmp", output})), FileNotFoundError);
+
+    REQUIRE_FALSE(cache.Fetch(*key, job));
+
+    // the stored output is copied to the output path of the job
+    const std::string temporary_path = cache.TemporaryPath(job);
+    std::filesystem::copy_file(input, temporary_path);
+    cache.Store(*key, temporary_path, job);
+
+    REQUIRE_FALSE(std::filesystem::exists(temporary_path));
+    REQUIRE(ReadBytes(input) == ReadBytes(output));
+
+    std::filesystem::remove(output);
+    REQUIRE(cache.Fetch(*key, job));
+    REQUIRE(ReadBytes(input) == ReadBytes(output));
+
+    // outputs over the capacity are removed, the least recently used first
+    ResultCache small(CACHE_PATH, std::filesystem::file_size(input) + 1);
+    const Pipeline other = Job({input, output, "-neg"});
+    const std::string other_key = *small.Key(other);
+    const std::string other_path = small.TemporaryPath(other);
+    std::filesystem::copy_file(input, other_path);
+    small.Store(other_key, other_path, other);
+
+    REQUIRE_FALSE(small.Fetch(*key, job));
+    REQUIRE(small.Fetch(other_key, other));
+
+    std::filesystem::remove_all(CACHE_PATH);
+    std::filesystem::remove(output);
+}
@@ -1,17 +1,47 @@
+#pragma once
+
+#include "codec.h"
 #include "image.h"
 #include "exceptions.h"
 
+#include <algorithm>
+#include <bit>
 #include <fstream>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace bmp_reader {
+struct Header {
+    int64_t width;
+    int64_t height;
+    bool top_down;
+    size_t bits_per_pixel;
+    uint32_t compression;
+    uint32_t red_mask;
+    uint32_t green_mask;
+    uint32_t blue_mask;
+    uint32_t alpha_mask;
+    std::vector<uint32_t> palette;  // color table of images with 8 and less bits per pixel
+    size_t horizontal_resolution;
+    size_t vertical_resolution;
+    size_t bitmap_offset;
+    uint64_t bitmap_size;  // computed from the dimensions, the header field is often left zero
+};
+
 uint32_t ByteRead(uint8_t* array, size_t start, size_t length);
 
 template <typename T>
 void ByteWrite(uint8_t* array, const T& data, size_t start, size_t length);
 
-Image* ReadFile(const std::string& file_path, Image* img);
+Header ReadHeader(const std::string& file_path);
+
+Image* ReadFile(const std::string& file_path, Image* img, const ReadOptions& options = {});
+
+// the stream is only read forward, so it can be a pipe
+Image* ReadStream(std::istream& f, Image* img, const ReadOptions& options = {});
+
+void SaveFile(const std::string& output_path, Image* img, const WriteOptions& options = {});
 
-void SaveFile(const std::string& output_path, Image* img);
+void SaveStream(std::ostream& f, Image* img, const WriteOptions& options = {});
 };  // namespace bmp_reader
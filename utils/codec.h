@@ -0,0 +1,138 @@
+#pragma once
+
+#include "image.h"
+#include "exceptions.h"
+
+#include <istream>
+#include <optional>
+#include <string>
+#include <vector>
+
+enum class ScaleMethod { average, stride };
+
+enum class YuvMatrix { bt601, bt709 };
+
+struct ReadOptions {
+    std::optional<Region> window;  // only this part of the image is read from the file, in scaled coordinates
+    int64_t scale = 1;             // image is decoded at 1/scale size, scale is one of 1, 2, 4, 8
+    ScaleMethod scale_method = ScaleMethod::average;  // stride reads only the first row of every block
+
+    // raw frames have no header, so their size and color matrix are given by the user
+    int64_t frame_width = 0;
+    int64_t frame_height = 0;
+    YuvMatrix matrix = YuvMatrix::bt601;
+
+    // only brightness is used, readers may skip chroma and return a grayscale image
+    bool luma_only = false;
+
+    std::string format;  // extension of the format of the standard input, detected by the signature if empty
+};
+
+enum class ColorDepth { automatic, rgb, grayscale, monochrome };
+
+struct WriteOptions {
+    // automatic writes grayscale images as 8 bits with a gray palette and monochrome ones as 1 bit bitmasks
+    ColorDepth depth = ColorDepth::rgb;
+    uint8_t sample_bits = 8;  // 8 or 16, formats without 16-bit samples always use 8
+    int64_t tile_size = 0;    // side of square tiles for formats with tiles, 0 - rows are stored in strips
+    std::string format;       // extension of the format of the standard output, .bmp if empty
+};
+
+// color channel of grayscale pixels, luma of the others
+double GrayLevel(const Pixel& pixel);
+
+// depth the image can be stored with without losses
+ColorDepth DetectColorDepth(Image& img);
+
+// size of a height x width raster of pixel_size bytes, throws for empty images and rasters whose offsets
+// do not fit 64 bits
+int64_t CheckRasterSize(int64_t height, int64_t width, int64_t pixel_size, const std::string& format);
+
+// throws if fewer bytes than size are left after the position of the stream, so a header of a truncated file
+// does not allocate its image; pipes have no known size and are not checked
+void CheckRemainingBytes(std::istream& f, int64_t size);
+
+// Collects decoded rows of a height x width image into an Image, keeping only the window from ReadOptions
+// and averaging scale x scale blocks, so the full-size image is never stored.
+// Rows of different blocks (y / Scale()) can be added from different threads.
+class ImageBuilder {
+private:
+    int64_t height_;
+    int64_t scale_;
+    ScaleMethod scale_method_;
+
+    Region window_;
+    Region source_;
+
+    std::vector<int64_t> rows_added_;
+    Image* img_;
+
+    int64_t BlockHeight(int64_t i) const;
+
+public:
+    ImageBuilder(int64_t height, int64_t width, size_t horizontal_resolution, size_t vertical_resolution,
+                 const ReadOptions& options);
+
+    ImageBuilder(const ImageBuilder&) = delete;
+    ImageBuilder& operator=(const ImageBuilder&) = delete;
+
+    ~ImageBuilder() {
+        delete img_;
+    }
+
+    // part of the source image which has to be decoded
+    const Region& Source() const {
+        return source_;
+    }
+
+    int64_t Scale() const {
+        return scale_;
+    }
+
+    bool IsRowNeeded(int64_t y) const {
+        return y >= source_.top && y < source_.top + source_.height &&
+               (scale_method_ == ScaleMethod::average || y % scale_ == 0);
+    }
+
+    // rgb holds 3 samples for every column of Source(), max_value is the sample value of the full intensity
+    template <typename T>
+    void AddRow(int64_t y, const T* rgb, double max_value) {
+        if (!IsRowNeeded(y)) {
+            return;
+        }
+
+        const int64_t i = y / scale_ - window_.top;
+        std::vector<Pixel>& pixels = img_->GetPixels()[i];
+
+        // sums are kept in the pixels until the whole block is read
+        for (int64_t x = 0; x != source_.width; ++x) {
+            Pixel& pixel = pixels[x / scale_];
+            pixel.r += static_cast<double>(rgb[3 * x]);
+            pixel.g += static_cast<double>(rgb[3 * x + 1]);
+            pixel.b += static_cast<double>(rgb[3 * x + 2]);
+        }
+
+        if (++rows_added_[i] != BlockHeight(i)) {
+            return;
+        }
+
+        for (int64_t j = 0; j != window_.width; ++j) {
+            const double block_size =
+                static_cast<double>(rows_added_[i] * std::min(scale_, source_.width - j * scale_)) * max_value;
+            pixels[j] = Pixel(pixels[j].r / block_size, pixels[j].g / block_size, pixels[j].b / block_size);
+        }
+    }
+
+    // columns of a block are averaged by both scale methods and black and white pixels give gray ones,
+    // so a scaled monochrome source gives a grayscale image
+    Image* Release(ColorMode color_mode = ColorMode::rgb) {
+        if (color_mode == ColorMode::monochrome && scale_ != 1) {
+            color_mode = ColorMode::grayscale;
+        }
+
+        Image* img = img_;
+        img_ = nullptr;
+        img->SetColorMode(color_mode);
+        return img;
+    }
+};
@@ -10,6 +10,8 @@
 namespace console_interface {
 void Help();
 
+void PrintHeader(const bmp_reader::Header& header);
+
 size_t ParseArguments(char** arguments, size_t start, size_t size, std::string& current_filter,
                       std::queue<std::string>& parameters);
 
@@ -23,6 +23,13 @@ public:
     }
 };
 
+class ImageTooLargeError : public std::length_error {
+public:
+    explicit ImageTooLargeError(const std::string& format)
+        : std::length_error("Image is too large for " + format + " format") {
+    }
+};
+
 class NotImplementedError : public std::logic_error {
 public:
     explicit NotImplementedError() : std::logic_error("Function/method is not implemented yet") {
@@ -41,3 +48,10 @@ public:
         : std::runtime_error("Invalid parameters for " + filter_name + " filter") {
     }
 };
+
+class InvalidGraphError : public std::runtime_error {
+public:
+    explicit InvalidGraphError(size_t line)
+        : std::runtime_error("Invalid graph description at line " + std::to_string(line)) {
+    }
+};
@@ -4,6 +4,8 @@
 #include "exceptions.h"
 #include "math.h"
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <tuple>
@@ -32,28 +34,61 @@ protected:
                                                    const std::vector<std::vector<int16_t>>& matrix) const;
 };
 
+// every filter parses its command line parameters into Parameters once, before any image is read
 class CropFilter : public AbstractFilter {
 public:
     static const std::string ALIAS;
 
+    struct Parameters {
+        int64_t width;
+        int64_t height;
+    };
+
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
     void Apply(Image& img, std::queue<std::string> parameters) const override;
+    void Apply(Image& img, const Parameters& parameters) const;
 };
 
 class GrayscaleFilter : public AbstractFilter {
 private:
-    static const std::tuple<double, double, double> COEFS;
+    static constexpr std::tuple<double, double, double> COEFS = {0.299, 0.587, 0.114};
 
 public:
     static const std::string ALIAS;
 
+    struct Parameters {};
+
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
+    // defined here, so that fused pipelines can inline it
+    static void Transform(Pixel& pixel) {
+        Pixel multiplied = pixel * COEFS;
+        double new_color = multiplied.r + multiplied.g + multiplied.b;
+
+        pixel = Pixel(new_color, new_color, new_color);
+    }
+
     void Apply(Image& img, std::queue<std::string> parameters) const override;
+    void Apply(Image& img, const Parameters& parameters) const;
 };
 
 class NegativeFilter : public AbstractFilter {
 public:
     static const std::string ALIAS;
 
+    struct Parameters {};
+
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
+    static void Transform(Pixel& pixel) {
+        pixel.r = 1 - pixel.r;
+        pixel.g = 1 - pixel.g;
+        pixel.b = 1 - pixel.b;
+    }
+
     void Apply(Image& img, std::queue<std::string> parameters) const override;
+    void Apply(Image& img, const Parameters& parameters) const;
 };
 
 class SharpeningFilter : public AbstractMatrixFilter {
@@ -63,7 +98,15 @@ private:
 public:
     static const std::string ALIAS;
 
+    struct Parameters {};
+
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
+    // distance to the farthest pixel the filter reads around every pixel
+    static int64_t Radius(const Parameters& parameters);
+
     void Apply(Image& img, std::queue<std::string> parameters) const override;
+    void Apply(Image& img, const Parameters& parameters) const;
 };
 
 class EdgeDetectionFilter : public AbstractMatrixFilter {
@@ -73,7 +116,24 @@ private:
 public:
     static const std::string ALIAS;
 
+    struct Parameters {
+        double threshold;
+    };
+
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
+    // distance to the farthest pixel the filter reads around every pixel
+    static int64_t Radius(const Parameters& parameters);
+
+    // Laplacian of the brightness, which is compared with the threshold, the image is converted to grayscale.
+    // It does not depend on the threshold, so it can be kept while the threshold is tuned.
+    std::vector<std::vector<double>> Response(Image& img) const;
+
+    // black and white image of the pixels with the response not less than the threshold, of the size of the response
+    static void Threshold(Image& img, const std::vector<std::vector<double>>& response, double threshold);
+
     void Apply(Image& img, std::queue<std::string> parameters) const override;
+    void Apply(Image& img, const Parameters& parameters) const;
 };
 
 class GaussianBlurFilter : public AbstractFilter {
@@ -85,7 +145,124 @@ private:
 public:
     static const std::string ALIAS;
 
+    struct Parameters {
+        double sigma;
+    };
+
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
     static std::vector<double> CalculateGaussianCoefficients(double sigma);
 
+    static int64_t Radius(const Parameters& parameters);
+
     void Apply(Image& img, std::queue<std::string> parameters) const override;
+    void Apply(Image& img, const Parameters& parameters) const;
+};
+
+// Run of point filters fused by the pipeline: every pixel is read, passed through all operations
+// and written back once, so the image is traversed once instead of once per filter.
+class PointFilter : public AbstractFilter {
+public:
+    enum class Operation { grayscale, negative };
+
+    struct Parameters {
+        std::vector<Operation> operations;
+    };
+
+    void Apply(Image& img, const Parameters& parameters) const;
+};
+
+// Chain of stencil and point filters fused by the pipeline. The image is processed in tiles: every tile is cut out
+// with the halo the whole chain reads around it, the stages run on the small tile and only its core is kept,
+// so intermediate images stay in the cache. Tiles are independent and are processed in parallel.
+class TiledFilter : public AbstractFilter {
+public:
+    struct Parameters {
+        std::vector<std::function<void(Image&)>> stages;
+        int64_t halo;  // sum of the radii of the stages
+    };
+
+    void Apply(Image& img, const Parameters& parameters) const;
+};
+
+// Applies one filter only inside the region, the pixels outside it stay the same. The region is cut out with
+// the halo the filter reads around it, so the filter processes only the region and its halo.
+class RegionFilter : public AbstractFilter {
+public:
+    static const std::string ALIAS;
+
+    struct Parameters {
+        Region region;
+        std::function<void(Image&)> filter;  // set by the pipeline from the next filter of the command line
+        int64_t halo;                        // radius of the filter
+        std::string description;             // the filter as in the command line
+    };
+
+    // "x y width height" of the region
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
+    void Apply(Image& img, const Parameters& parameters) const;
+};
+
+// Applies one filter where the mask is not black: pixels under white mask pixels are replaced by the filtered ones,
+// pixels under gray ones are mixed with them. The part of the image the mask does not cover stays the same.
+// The image is split into tiles, the tiles the mask excludes are skipped and every run of the other tiles
+// of a row is filtered at once with the halo around it, so sparse masks cost only the work on the pixels they select.
+class MaskedFilter : public AbstractFilter {
+public:
+    static const std::string ALIAS;
+
+    struct Parameters {
+        std::string path;                    // file of the mask, empty if the mask is computed by the graph
+        std::shared_ptr<const Image> mask;   // read from the path when the filter is applied
+        std::function<void(Image&)> filter;  // set by the pipeline from the next filter of the command line
+        int64_t halo;                        // radius of the filter
+        std::string description;             // the filter as in the command line
+    };
+
+    // path of the mask
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
+    void Apply(Image& img, const Parameters& parameters) const;
+};
+
+// Filters of the graph combining several images. The first input is changed in place, the others are only read.
+// The result keeps the top left part of the inputs, which all of them cover.
+class BlendFilter : public AbstractFilter {
+public:
+    static const std::string ALIAS;
+    static constexpr size_t INPUTS = 2;
+
+    struct Parameters {
+        double alpha;  // weight of the second input
+    };
+
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
+    void Apply(Image& img, const std::vector<const Image*>& others, const Parameters& parameters) const;
+};
+
+// takes pixels of the first input where the brightness of the mask is 1 and of the second one where it is 0
+class MaskFilter : public AbstractFilter {
+public:
+    static const std::string ALIAS;
+    static constexpr size_t INPUTS = 3;
+
+    struct Parameters {};
+
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
+    void Apply(Image& img, const std::vector<const Image*>& others, const Parameters& parameters) const;
+};
+
+class DifferenceFilter : public AbstractFilter {
+public:
+    static const std::string ALIAS;
+    static constexpr size_t INPUTS = 2;
+
+    struct Parameters {};
+
+    static Parameters ParseParameters(std::queue<std::string> parameters);
+
+    void Apply(Image& img, const std::vector<const Image*>& others, const Parameters& parameters) const;
 };
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "image.h"
+#include "exceptions.h"
+#include "filters.h"
+#include "pipeline.h"
+
+#include <istream>
+#include <string>
+#include <variant>
+#include <vector>
+
+using CombiningNode = std::variant<Node<BlendFilter>, Node<MaskFilter>, Node<DifferenceFilter>>;
+
+// image read from a file
+struct SourceNode {
+    std::string path;
+};
+
+// node of the graph, inputs are indices of earlier vertices
+struct Vertex {
+    std::variant<SourceNode, FilterNode, CombiningNode> operation;
+    std::vector<size_t> inputs;
+};
+
+// Filter graph, the vertices are stored in topological order. Equal operations applied to the same inputs
+// are stored once, so a shared prefix of several chains is computed once.
+struct Graph {
+    std::vector<Vertex> vertices;
+    std::vector<std::tuple<size_t, std::string>> outputs;  // vertex and path for every saved image
+};
+
+// A graph is described line by line:
+//
+//     photo = photo.bmp
+//     soft = photo -blur 2
+//     edges = soft -edge 0.1
+//     result = blend soft photo 0.3 -neg
+//     save edges edges.bmp
+//     save result result.bmp
+//
+// A line defines a name by a file, by another name or by a combining filter (blend a b alpha, mask a b mask,
+// difference a b), followed by filters as in the command line. The mask of -mask is a name or a file, so a filter
+// can be applied only where an -edge result is white. Empty lines and lines starting with # are skipped.
+namespace graph {
+Graph Parse(std::istream& description);
+
+// "-" reads the description from the standard input
+Graph ParseFile(const std::string& file_path);
+
+// Computes the saved vertices. Every vertex is computed once and its image is freed after its last consumer,
+// the last consumer applies its filter in place instead of copying the image.
+void Run(const Graph& graph);
+};  // namespace graph
@@ -10,7 +10,7 @@
 
 struct Pixel {
 private:
-    const double epsilon_ = 1e-2;
+    static constexpr double epsilon_ = 1e-2;
 
     void SetColor(double r, double g, double b) {
         this->r = std::max(0.0, std::min(1.0, r));
@@ -19,7 +19,7 @@ private:
     }
 
 public:
-    const double max_color = 255.0;
+    static constexpr double max_color = 255.0;
 
     double r;
     double g;
@@ -103,6 +103,17 @@ public:
     }
 };
 
+struct Region {
+    int64_t top;
+    int64_t left;
+    int64_t height;
+    int64_t width;
+};
+
+// grayscale images have equal color channels, so they can be stored with a single channel,
+// monochrome images are grayscale images with only black and white pixels, so they can be stored with one bit
+enum class ColorMode { rgb, grayscale, monochrome };
+
 class Image {
 private:
     int64_t height_;
@@ -111,6 +122,8 @@ private:
     size_t horizontal_resolution_;
     size_t vertical_resolution_;
 
+    ColorMode color_mode_ = ColorMode::rgb;
+
     std::vector<std::vector<Pixel>> pixels_;
 
 public:
@@ -163,6 +176,10 @@ public:
         return pixels_;
     }
 
+    const std::vector<std::vector<Pixel>>& GetPixels() const {
+        return pixels_;
+    }
+
     std::tuple<int64_t, int64_t> Shape() const {
         return std::make_tuple(height_, width_);
     }
@@ -175,4 +192,12 @@ public:
     std::tuple<size_t, size_t> Resolution() const {
         return std::make_tuple(horizontal_resolution_, vertical_resolution_);
     }
+
+    void SetColorMode(ColorMode color_mode) {
+        color_mode_ = color_mode;
+    }
+
+    ColorMode GetColorMode() const {
+        return color_mode_;
+    }
 };
\ No newline at end of file
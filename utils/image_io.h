@@ -0,0 +1,24 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+
+#include <string>
+
+// chooses the image codec by the file extension, "-" stands for the standard input or output
+namespace image_io {
+const std::string STANDARD_STREAM = "-";
+
+bool IsSupported(const std::string& file_path);
+
+// extension of the format with the dot, as in ReadOptions::format and WriteOptions::format
+bool IsFormatSupported(const std::string& extension);
+
+Image* ReadFile(const std::string& file_path, Image* img, const ReadOptions& options = {});
+
+// extension of the format the output is saved in, with the dot
+std::string OutputFormat(const std::string& output_path, const WriteOptions& options = {});
+
+void SaveFile(const std::string& output_path, Image* img, const WriteOptions& options = {});
+};  // namespace image_io
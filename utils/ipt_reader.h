@@ -0,0 +1,24 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+
+#include <fstream>
+#include <string>
+
+// native tiled format: a 64-byte header and square tiles of pixels stored as in memory (three doubles per pixel,
+// host byte order). The file is memory mapped, so reading a region touches only the tiles it intersects
+// and needs no decoding. Repeated uniform tiles are stored once and found through a per-tile index.
+namespace ipt_reader {
+Image* ReadFile(const std::string& file_path, Image* img, const ReadOptions& options = {});
+
+// streams cannot be mapped, so the stream is read into memory first
+Image* ReadStream(std::istream& f, Image* img, const ReadOptions& options = {});
+
+// tiles are WriteOptions::tile_size pixels wide, 256 by default
+void SaveFile(const std::string& output_path, Image* img, const WriteOptions& options = {});
+
+// the file is written sequentially, so the stream can be a pipe
+void SaveStream(std::ostream& f, Image* img, const WriteOptions& options = {});
+};  // namespace ipt_reader
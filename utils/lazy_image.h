@@ -0,0 +1,44 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+#include "pipeline.h"
+
+#include <memory>
+#include <string>
+
+// Image described by its source and the filters applied to it. Applying a filter only adds a node to the graph,
+// pixels are computed by Materialize() or SaveFile(), and only the part of every intermediate image the result
+// depends on is computed: a crop at the end of the chain limits the rows and columns read from the file and
+// filtered before it. Nodes are immutable and shared, so one image can be the input of several chains.
+class LazyImage {
+private:
+    struct Expression;
+
+    std::shared_ptr<const Expression> expression_;
+
+    explicit LazyImage(std::shared_ptr<const Expression> expression) : expression_(std::move(expression)) {
+    }
+
+    // needed_height x needed_width is the top left part of the result which has to be exact,
+    // the returned image can be larger
+    static Image* Evaluate(const Expression& expression, int64_t needed_height, int64_t needed_width);
+
+public:
+    // the file is read only when the pixels are needed
+    static LazyImage Read(const std::string& file_path, const ReadOptions& options = {});
+
+    // the image is copied, so it can be changed or deleted after the call
+    static LazyImage FromImage(const Image& img);
+
+    // the image is shared and never changed, every evaluation copies only the part it needs
+    static LazyImage FromImage(std::shared_ptr<const Image> img);
+
+    LazyImage Apply(const FilterNode& filter) const;
+
+    // the caller owns the returned image
+    Image* Materialize() const;
+
+    void SaveFile(const std::string& output_path, const WriteOptions& options = {}) const;
+};
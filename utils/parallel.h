@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// Splits [0, count) into contiguous ranges and calls body(begin, end) for every range on its own thread.
+// The first exception thrown by any range is rethrown after all threads finish.
+template <typename Body>
+void ParallelFor(int64_t count, Body body) {
+    const int64_t threads_count =
+        std::min(count, static_cast<int64_t>(std::max(1u, std::thread::hardware_concurrency())));
+
+    if (threads_count <= 1) {
+        body(0l, count);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(threads_count);
+
+    for (int64_t t = 0; t != threads_count; ++t) {
+        threads.emplace_back([&, t]() {
+            try {
+                body(count * t / threads_count, count * (t + 1) / threads_count);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
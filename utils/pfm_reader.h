@@ -0,0 +1,21 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+
+#include <fstream>
+#include <string>
+
+// Portable FloatMap: 32-bit float samples, so intermediate images are saved without 8-bit quantization
+namespace pfm_reader {
+Image* ReadFile(const std::string& file_path, Image* img, const ReadOptions& options = {});
+
+// the stream is only read forward, so it can be a pipe
+Image* ReadStream(std::istream& f, Image* img, const ReadOptions& options = {});
+
+// grayscale and monochrome images are saved with one channel (Pf), others with three (PF)
+void SaveFile(const std::string& output_path, Image* img, const WriteOptions& options = {});
+
+void SaveStream(std::ostream& f, Image* img, const WriteOptions& options = {});
+};  // namespace pfm_reader
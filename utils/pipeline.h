@@ -0,0 +1,64 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+#include "filters.h"
+
+#include <string>
+#include <variant>
+#include <vector>
+
+// filter with its parsed parameters
+template <typename F>
+struct Node {
+    using Filter = F;
+
+    typename Filter::Parameters parameters;
+};
+
+using FilterNode = std::variant<Node<CropFilter>, Node<GrayscaleFilter>, Node<NegativeFilter>, Node<SharpeningFilter>,
+                                Node<EdgeDetectionFilter>, Node<GaussianBlurFilter>, Node<PointFilter>,
+                                Node<TiledFilter>, Node<RegionFilter>, Node<MaskedFilter>>;
+
+// the whole command line, parsed and validated before any image is read
+struct Pipeline {
+    std::string input_path;
+    std::string output_path;
+    ReadOptions read_options;
+    WriteOptions write_options;
+    std::vector<FilterNode> filters;
+    std::vector<std::string> rewrites;  // log of the optimizer, "-neg -neg -> nothing" and so on
+    std::string description;            // filters after the optimizer, the same for equivalent command lines
+};
+
+namespace pipeline {
+// argv holds the paths, reader and writer options and the filters, a wrong argument throws before any I/O.
+// Filters are optimized, then a leading crop is moved into ReadOptions::window, a grayscale filter after it
+// sets ReadOptions::luma_only, runs of the other point filters are fused into PointFilter passes
+// and chains with stencil filters into TiledFilter passes.
+Pipeline Parse(int argc, char** argv);
+
+// Several outputs of one input: {input} [common options] -o {output 1} [options] [filters] -o {output 2} ...
+// Decoder options are common, every output has its own writer options and filters. The pipelines share
+// the input and ReadOptions, a command line without -o gives the single pipeline of Parse.
+std::vector<Pipeline> ParseOutputs(int argc, char** argv);
+
+// filter with the given alias, as in the command line
+FilterNode ParseFilter(const std::string& alias, std::queue<std::string> parameters);
+
+// the filter applied only inside the region of -roi, crops, regions and masks can not be restricted
+FilterNode Restrict(RegionFilter::Parameters region, const FilterNode& filter);
+
+// the filter applied only where the mask of -mask is not black
+FilterNode Restrict(MaskedFilter::Parameters mask, const FilterNode& filter);
+
+// Rewrites the filters into a cheaper equivalent chain: -neg -neg is removed, -gs -gs becomes -gs, adjacent crops
+// are merged and crops are moved before point filters. Returns the applied rewrites.
+std::vector<std::string> Optimize(std::vector<FilterNode>& filters);
+
+// distance to the farthest pixel of the input the filter reads around every pixel
+int64_t Radius(const FilterNode& filter);
+
+void Apply(const FilterNode& filter, Image& img);
+};  // namespace pipeline
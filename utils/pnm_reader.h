@@ -0,0 +1,22 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+
+#include <fstream>
+#include <string>
+
+// binary Netpbm formats: PGM (P5), PPM (P6) and PAM (P7) with 8 or 16 bits samples
+namespace pnm_reader {
+Image* ReadFile(const std::string& file_path, Image* img, const ReadOptions& options = {});
+
+// the stream is only read forward, so it can be a pipe
+Image* ReadStream(std::istream& f, Image* img, const ReadOptions& options = {});
+
+// .pgm is saved as P5, .ppm as P6, .pam as P7 and .pnm as P5 or P6 depending on the color depth
+void SaveFile(const std::string& output_path, Image* img, const WriteOptions& options = {});
+
+// extension of the format: .pgm, .ppm, .pam or .pnm
+void SaveStream(std::ostream& f, Image* img, const WriteOptions& options, const std::string& extension);
+};  // namespace pnm_reader
@@ -1,6 +1,11 @@
 #include "bmp_reader.h"
+#include "image_io.h"
 #include "exceptions.h"
 #include "console_interface.h"
 #include "filters.h"
+#include "graph.h"
+#include "lazy_image.h"
+#include "pipeline.h"
+#include "result_cache.h"
 
 void ImageProcessor(int argc, char** argv);
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+
+#include <fstream>
+#include <string>
+
+// "Quite OK Image" lossless format, https://qoiformat.org/qoi-specification.pdf
+namespace qoi_reader {
+Image* ReadFile(const std::string& file_path, Image* img, const ReadOptions& options = {});
+
+// the stream is only read forward, so it can be a pipe
+Image* ReadStream(std::istream& f, Image* img, const ReadOptions& options = {});
+
+void SaveFile(const std::string& output_path, Image* img, const WriteOptions& options = {});
+
+void SaveStream(std::ostream& f, Image* img, const WriteOptions& options = {});
+};  // namespace qoi_reader
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+#include "pipeline.h"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+// Results of filter chains kept between runs of an interactive tool, which runs one chain again and again while
+// a parameter is tuned. Every prefix of the chain is stored by the file, its read options and the filters with
+// their parameters, so a run starts from the longest prefix computed before: a new parameter of the last filter
+// applies only that filter. The Laplacian of -edge does not depend on the threshold and is stored instead of
+// the black and white result, so a new threshold only compares the stored response with it. Least recently used
+// results are dropped when their total size exceeds the capacity.
+//
+// Crop, grayscale, negative, sharpening, edge detection and blur results are stored, the filters after any other
+// filter are applied on every run. The cache is not thread-safe.
+class RecomputeCache {
+private:
+    struct EdgeResponse {
+        std::vector<std::vector<double>> values;
+        size_t horizontal_resolution;
+        size_t vertical_resolution;
+    };
+
+    struct Entry {
+        std::variant<Image, EdgeResponse> value;
+        size_t bytes;
+        std::list<std::string>::iterator position;  // in recent_
+    };
+
+    size_t capacity_;
+    size_t size_ = 0;
+    size_t last_applied_ = 0;
+    std::list<std::string> recent_;  // keys of the entries, the most recently used first
+    std::unordered_map<std::string, Entry> entries_;
+
+    // the entry is marked as used, nullptr if it is not stored
+    template <typename Value>
+    const Value* Find(const std::string& key);
+
+    // values larger than the capacity are not stored
+    template <typename Value>
+    void Store(const std::string& key, Value value, size_t bytes);
+
+public:
+    static const size_t DEFAULT_CAPACITY;  // bytes
+
+    explicit RecomputeCache(size_t capacity = DEFAULT_CAPACITY);
+
+    // The image of the file with the filters applied, the caller owns it. Files changed since their results
+    // were stored are read again, the standard input is never stored.
+    Image* Run(const std::string& input_path, const ReadOptions& read_options, const std::vector<FilterNode>& filters);
+
+    // filters applied by the last run, the others were taken from the cache
+    size_t LastApplied() const;
+
+    // total size of the stored images and responses in bytes
+    size_t Size() const;
+
+    void Clear();
+};
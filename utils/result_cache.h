@@ -0,0 +1,47 @@
+#pragma once
+
+#include "codec.h"
+#include "exceptions.h"
+#include "pipeline.h"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+// Encoded outputs of jobs stored in a directory, so a repeated job copies its output without decoding anything.
+// An output is stored by a hash of the contents of the input and the masks and a hash of the job: the filters
+// after the optimizer, the read and write options and the output format, so equivalent command lines share it.
+// Least recently used outputs are removed when the directory grows over the capacity.
+//
+// Several processes can use one directory at once: outputs are written to temporary files and renamed into place,
+// so an output is either missing or complete, and an output removed while it is copied is read to the end.
+class ResultCache {
+private:
+    std::string directory_;
+    uint64_t capacity_;
+    std::map<std::string, uint64_t> file_hashes_;  // the input is hashed once for all outputs of a job
+
+    uint64_t HashFile(const std::string& file_path);
+
+    // removes the least recently used outputs over the capacity and temporary files left by crashed processes
+    void Evict() const;
+
+public:
+    static const uint64_t DEFAULT_CAPACITY;  // bytes
+
+    // the directory is created if it does not exist
+    explicit ResultCache(std::string directory, uint64_t capacity = DEFAULT_CAPACITY);
+
+    // name of the stored output of the job, empty if the input is the standard input
+    std::optional<std::string> Key(const Pipeline& pipeline);
+
+    // copies the stored output to the output path of the job, false if it is not stored
+    bool Fetch(const std::string& key, const Pipeline& pipeline) const;
+
+    // a new file in the directory for the output of the job, in the format of its output path
+    std::string TemporaryPath(const Pipeline& pipeline) const;
+
+    // moves the output saved to the temporary path into the cache and copies it to the output path of the job
+    void Store(const std::string& key, const std::string& temporary_path, const Pipeline& pipeline) const;
+};
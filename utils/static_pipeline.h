@@ -0,0 +1,362 @@
+#pragma once
+
+#include "image.h"
+#include "filters.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Filter chains known at compile time, for callers that link the library and always run the same filters:
+//
+//     static_pipeline::Pipeline<static_pipeline::Grayscale, static_pipeline::Negative, static_pipeline::Sharpen>()
+//         .Apply(img);
+//
+// There is no virtual dispatch and no parameter parsing. The chain is split into stencil steps, every point
+// filter after a stencil step is inlined into the loop computing its pixels, and the image is processed row by row:
+// every stencil step keeps only the few rows of the previous step it reads, so the intermediate images are never
+// stored. The result is exactly the result of the filters from filters.h applied one by one.
+namespace static_pipeline {
+
+// rows of the previous step around the current row, coordinates are clamped like in Image::Get
+class Window {
+private:
+    const Pixel* const* rows_;
+    int64_t radius_;
+    int64_t width_;
+
+public:
+    Window(const Pixel* const* rows, int64_t radius, int64_t width) : rows_(rows), radius_(radius), width_(width) {
+    }
+
+    const Pixel& Get(int64_t dy, int64_t x) const {
+        return rows_[radius_ + dy][std::clamp(x, 0l, width_ - 1)];
+    }
+};
+
+// A step is either a point step with Transform(Pixel&) or a stencil step with Radius() of the rows it reads above
+// and below and Compute(window, x). Filters are made of steps.
+
+struct GrayscaleStep {
+    static constexpr bool POINT = true;
+
+    void Transform(Pixel& pixel) const {
+        GrayscaleFilter::Transform(pixel);
+    }
+
+    ColorMode Mode(ColorMode mode) const {
+        return ColorMode::grayscale;
+    }
+};
+
+struct NegativeStep {
+    static constexpr bool POINT = true;
+
+    void Transform(Pixel& pixel) const {
+        NegativeFilter::Transform(pixel);
+    }
+
+    ColorMode Mode(ColorMode mode) const {
+        return mode;
+    }
+};
+
+// the sums keep the order of AbstractMatrixFilter::ApplyMatrix, the terms with zero weights are left out
+struct SharpenStep {
+    static constexpr bool POINT = false;
+
+    int64_t Radius() const {
+        return 1;
+    }
+
+    Pixel Compute(const Window& window, int64_t x) const {
+        const Pixel& top = window.Get(-1, x);
+        const Pixel& left = window.Get(0, x - 1);
+        const Pixel& center = window.Get(0, x);
+        const Pixel& right = window.Get(0, x + 1);
+        const Pixel& bottom = window.Get(1, x);
+
+        return Pixel(-top.r - left.r + center.r * 5 - right.r - bottom.r,   // NOLINT
+                     -top.g - left.g + center.g * 5 - right.g - bottom.g,   // NOLINT
+                     -top.b - left.b + center.b * 5 - right.b - bottom.b);  // NOLINT
+    }
+
+    ColorMode Mode(ColorMode mode) const {
+        return mode == ColorMode::monochrome ? ColorMode::grayscale : mode;
+    }
+};
+
+// the input is grayscale, so only the red channel is filtered
+struct EdgeStep {
+    static constexpr bool POINT = false;
+
+    double threshold;
+
+    int64_t Radius() const {
+        return 1;
+    }
+
+    Pixel Compute(const Window& window, int64_t x) const {
+        const double color = -window.Get(-1, x).r - window.Get(0, x - 1).r + window.Get(0, x).r * 4 -  // NOLINT
+                             window.Get(0, x + 1).r - window.Get(1, x).r;
+
+        return color >= threshold ? Pixel(1., 1., 1.) : Pixel(0., 0., 0.);
+    }
+
+    ColorMode Mode(ColorMode mode) const {
+        return ColorMode::monochrome;
+    }
+};
+
+// one direction of the separable blur, the horizontal one reads only the current row
+template <bool Vertical>
+struct BlurStep {
+    static constexpr bool POINT = false;
+
+    std::vector<double> coefficients;
+
+    int64_t Radius() const {
+        return Vertical ? static_cast<int64_t>(coefficients.size() - 1) / 2 : 0;
+    }
+
+    Pixel Compute(const Window& window, int64_t x) const {
+        const int64_t radius = static_cast<int64_t>(coefficients.size() - 1) / 2;
+        double red = 0;
+        double green = 0;
+        double blue = 0;
+
+        for (size_t k = 0; k != coefficients.size(); ++k) {
+            const int64_t offset = static_cast<int64_t>(k) - radius;
+            const Pixel& pixel = Vertical ? window.Get(offset, x) : window.Get(0, x + offset);
+
+            red += pixel.r * coefficients[k];
+            green += pixel.g * coefficients[k];
+            blue += pixel.b * coefficients[k];
+        }
+
+        return Pixel(red, green, blue);
+    }
+
+    ColorMode Mode(ColorMode mode) const {
+        return Vertical && mode == ColorMode::monochrome ? ColorMode::grayscale : mode;
+    }
+};
+
+// filters of the chain, every filter is expanded into its steps
+
+struct Grayscale {
+    std::tuple<GrayscaleStep> Steps() const {
+        return {};
+    }
+};
+
+struct Negative {
+    std::tuple<NegativeStep> Steps() const {
+        return {};
+    }
+};
+
+struct Sharpen {
+    std::tuple<SharpenStep> Steps() const {
+        return {};
+    }
+};
+
+struct EdgeDetection {
+    double threshold;
+
+    std::tuple<GrayscaleStep, EdgeStep> Steps() const {
+        return {GrayscaleStep{}, EdgeStep{threshold}};
+    }
+};
+
+struct Blur {
+    double sigma;
+
+    std::tuple<BlurStep<false>, BlurStep<true>> Steps() const {
+        const std::vector<double> coefficients = GaussianBlurFilter::CalculateGaussianCoefficients(sigma);
+        return {BlurStep<false>{coefficients}, BlurStep<true>{coefficients}};
+    }
+};
+
+template <typename... Filters>
+class Pipeline {
+private:
+    using Steps = decltype(std::tuple_cat(std::declval<Filters>().Steps()...));
+
+    static constexpr size_t STEPS_COUNT = std::tuple_size_v<Steps>;
+
+    template <size_t... I>
+    static constexpr std::array<bool, STEPS_COUNT> ArePoints(std::index_sequence<I...>) {
+        return {std::tuple_element_t<I, Steps>::POINT...};
+    }
+
+    static constexpr std::array<bool, STEPS_COUNT> IS_POINT = ArePoints(std::make_index_sequence<STEPS_COUNT>());
+
+    // group 0 is the input with the point steps before the first stencil step,
+    // every other group is a stencil step with the point steps after it
+    static constexpr size_t GROUPS_COUNT = 1 + std::count(IS_POINT.begin(), IS_POINT.end(), false);
+
+    static constexpr std::array<size_t, GROUPS_COUNT + 1> FindGroups() {
+        std::array<size_t, GROUPS_COUNT + 1> begins{};
+        size_t group = 1;
+
+        for (size_t i = 0; i != STEPS_COUNT; ++i) {
+            if (!IS_POINT[i]) {
+                begins[group++] = i;
+            }
+        }
+
+        begins[GROUPS_COUNT] = STEPS_COUNT;
+        return begins;
+    }
+
+    // index of the first step of every group
+    static constexpr std::array<size_t, GROUPS_COUNT + 1> GROUP_BEGINS = FindGroups();
+
+    // last rows computed by a group, row y is kept at y % rows.size()
+    struct RowBuffer {
+        std::vector<std::vector<Pixel>> rows;
+        int64_t next;
+    };
+
+    struct Band {
+        const std::vector<std::vector<Pixel>>& input;
+        std::array<RowBuffer, GROUPS_COUNT> buffers;
+        std::vector<const Pixel*> window;
+    };
+
+    Steps steps_;
+
+    template <size_t Begin, size_t End>
+    void ApplyPoints(Pixel& pixel) const {
+        if constexpr (Begin < End) {
+            std::get<Begin>(steps_).Transform(pixel);
+            ApplyPoints<Begin + 1, End>(pixel);
+        }
+    }
+
+    template <size_t I = 0>
+    ColorMode Mode(ColorMode mode) const {
+        if constexpr (I < STEPS_COUNT) {
+            return Mode<I + 1>(std::get<I>(steps_).Mode(mode));
+        } else {
+            return mode;
+        }
+    }
+
+    template <size_t Group>
+    int64_t Radius() const {
+        if constexpr (Group == 0) {
+            return 0;
+        } else {
+            return std::get<GROUP_BEGINS[Group]>(steps_).Radius();
+        }
+    }
+
+    template <size_t... Groups>
+    std::array<int64_t, GROUPS_COUNT> Radii(std::index_sequence<Groups...>) const {
+        return {Radius<Groups>()...};
+    }
+
+    // computes the rows of the group up to the given one
+    template <size_t Group>
+    void Produce(Band& band, int64_t last_row) const {
+        RowBuffer& buffer = band.buffers[Group];
+
+        for (; buffer.next <= last_row; ++buffer.next) {
+            ComputeRow<Group>(band, buffer.next, buffer.rows[buffer.next % buffer.rows.size()]);
+        }
+    }
+
+    template <size_t Group>
+    void ComputeRow(Band& band, int64_t y, std::vector<Pixel>& row) const {
+        const auto height = static_cast<int64_t>(band.input.size());
+        const auto width = static_cast<int64_t>(row.size());
+        constexpr size_t POINTS_END = GROUP_BEGINS[Group + 1];
+
+        if constexpr (Group == 0) {
+            const std::vector<Pixel>& input_row = band.input[y];
+
+            for (int64_t x = 0; x != width; ++x) {
+                Pixel pixel = input_row[x];
+                ApplyPoints<0, POINTS_END>(pixel);
+                row[x] = pixel;
+            }
+        } else {
+            const auto& step = std::get<GROUP_BEGINS[Group]>(steps_);
+            const int64_t radius = step.Radius();
+            Produce<Group - 1>(band, std::min(y + radius, height - 1));
+
+            const RowBuffer& previous = band.buffers[Group - 1];
+            band.window.resize(2 * radius + 1);
+            for (int64_t dy = -radius; dy <= radius; ++dy) {
+                const int64_t source_row = std::clamp(y + dy, 0l, height - 1);
+                band.window[radius + dy] = previous.rows[source_row % previous.rows.size()].data();
+            }
+
+            const Window window(band.window.data(), radius, width);
+
+            for (int64_t x = 0; x != width; ++x) {
+                Pixel pixel = step.Compute(window, x);
+                ApplyPoints<GROUP_BEGINS[Group] + 1, POINTS_END>(pixel);
+                row[x] = pixel;
+            }
+        }
+    }
+
+public:
+    Pipeline() requires(sizeof...(Filters) != 0) : Pipeline(Filters{}...) {
+    }
+
+    explicit Pipeline(Filters... filters) : steps_(std::tuple_cat(filters.Steps()...)) {
+    }
+
+    void Apply(Image& img) const {
+        auto [height, width] = img.Shape();
+        std::vector<std::vector<Pixel>>& pixels = img.GetPixels();
+
+        if (height == 0 || width == 0) {
+            return;
+        }
+
+        if constexpr (GROUPS_COUNT == 1) {
+            // only point steps, the pixels are changed in place
+            ParallelFor(height, [&](int64_t begin, int64_t end) {
+                for (int64_t y = begin; y != end; ++y) {
+                    for (Pixel& pixel : pixels[y]) {
+                        ApplyPoints<0, STEPS_COUNT>(pixel);
+                    }
+                }
+            });
+        } else {
+            const std::array<int64_t, GROUPS_COUNT> radii = Radii(std::make_index_sequence<GROUPS_COUNT>());
+            std::vector<std::vector<Pixel>> new_data(height, std::vector<Pixel>(width));
+
+            // bands of rows are independent, every band starts from the rows of the input its first row depends on
+            ParallelFor(height, [&](int64_t begin, int64_t end) {
+                Band band{pixels, {}, {}};
+                int64_t first_row = begin;
+
+                for (size_t group = GROUPS_COUNT - 1; group-- != 0;) {
+                    first_row = std::max(0l, first_row - radii[group + 1]);
+                    band.buffers[group].rows.assign(2 * radii[group + 1] + 1, std::vector<Pixel>(width));
+                    band.buffers[group].next = first_row;
+                }
+
+                for (int64_t y = begin; y != end; ++y) {
+                    ComputeRow<GROUPS_COUNT - 1>(band, y, new_data[y]);
+                }
+            });
+
+            pixels = std::move(new_data);
+        }
+
+        img.SetColorMode(Mode(img.GetColorMode()));
+    }
+};
+}  // namespace static_pipeline
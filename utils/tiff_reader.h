@@ -0,0 +1,23 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+
+#include <fstream>
+#include <string>
+
+// baseline uncompressed TIFF and BigTIFF with 8 or 16 bits samples organized in strips or tiles,
+// strips and tiles are decoded and encoded in parallel
+namespace tiff_reader {
+Image* ReadFile(const std::string& file_path, Image* img, const ReadOptions& options = {});
+
+// directories and strips are read in any order, so the stream is read into memory first
+Image* ReadStream(std::istream& f, Image* img, const ReadOptions& options = {});
+
+// .btf files are always saved as BigTIFF, others only when they do not fit into 4 GB
+void SaveFile(const std::string& output_path, Image* img, const WriteOptions& options = {});
+
+// the file is written sequentially, so the stream can be a pipe, extension of the format is .tif, .tiff or .btf
+void SaveStream(std::ostream& f, Image* img, const WriteOptions& options, const std::string& extension);
+};  // namespace tiff_reader
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "codec.h"
+#include "image.h"
+#include "exceptions.h"
+
+#include <fstream>
+#include <string>
+
+// raw 8-bit YUV 4:2:0 frames with limited range samples: planar I420 (.yuv) and NV12 (.nv12) with interleaved
+// chroma. The frame size is taken from ReadOptions, only the first frame of the file is read.
+namespace yuv_reader {
+Image* ReadFile(const std::string& file_path, Image* img, const ReadOptions& options = {});
+
+// the stream is only read forward, so it can be a pipe, extension of the format is .yuv or .nv12
+Image* ReadStream(std::istream& f, Image* img, const ReadOptions& options, const std::string& extension);
+
+// frames are saved with the BT.601 matrix
+void SaveFile(const std::string& output_path, Image* img, const WriteOptions& options = {});
+
+void SaveStream(std::ostream& f, Image* img, const WriteOptions& options, const std::string& extension);
+};  // namespace yuv_reader